@@ -0,0 +1,173 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "fbx_bounds.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FBX2JSON_BOUNDS_SSE2
+#endif
+
+namespace Fbx2Json
+{
+
+Bounds::Bounds() : radius(-1.f)
+{
+  for(int k = 0; k < 3; ++k) {
+    min[k] = FLT_MAX;
+    max[k] = -FLT_MAX;
+    center[k] = 0.f;
+  }
+}
+
+static inline const float * point_at(const float * positions, const size_t stride, const unsigned int * indices, const size_t i)
+{
+  return positions + (indices != NULL ? indices[i] : i) * stride;
+}
+
+#ifdef FBX2JSON_BOUNDS_SSE2
+
+void add_points(Bounds & bounds, const float * positions, const size_t stride, const unsigned int * indices, const size_t count)
+{
+  __m128 lower = _mm_setr_ps(bounds.min[0], bounds.min[1], bounds.min[2], 0.f);
+  __m128 upper = _mm_setr_ps(bounds.max[0], bounds.max[1], bounds.max[2], 0.f);
+  float values[4];
+
+  for(size_t i = 0; i < count; ++i) {
+    const __m128 point = _mm_loadu_ps(point_at(positions, stride, indices, i));
+    lower = _mm_min_ps(lower, point);
+    upper = _mm_max_ps(upper, point);
+  }
+
+  _mm_storeu_ps(values, lower);
+  std::copy(values, values + 3, bounds.min);
+  _mm_storeu_ps(values, upper);
+  std::copy(values, values + 3, bounds.max);
+}
+
+// Squared distances from the centre, summed across the XYZ lanes of each
+// point with the W lane masked off.
+static float max_squared_distance(const float * center, const float * positions, const size_t stride,
+                                  const unsigned int * indices, const size_t count)
+{
+  const __m128 xyz_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  const __m128 origin = _mm_setr_ps(center[0], center[1], center[2], 0.f);
+  __m128 farthest = _mm_setzero_ps();
+
+  for(size_t i = 0; i < count; ++i) {
+    const __m128 offset = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(point_at(positions, stride, indices, i)), origin), xyz_mask);
+    const __m128 squared = _mm_mul_ps(offset, offset);
+    const __m128 sum = _mm_add_ss(_mm_add_ss(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(1, 1, 1, 1))),
+                                  _mm_movehl_ps(squared, squared));
+    farthest = _mm_max_ss(farthest, sum);
+  }
+
+  return _mm_cvtss_f32(farthest);
+}
+
+#else
+
+void add_points(Bounds & bounds, const float * positions, const size_t stride, const unsigned int * indices, const size_t count)
+{
+  for(size_t i = 0; i < count; ++i) {
+    const float * point = point_at(positions, stride, indices, i);
+
+    for(int k = 0; k < 3; ++k) {
+      bounds.min[k] = std::min(bounds.min[k], point[k]);
+      bounds.max[k] = std::max(bounds.max[k], point[k]);
+    }
+  }
+}
+
+static float max_squared_distance(const float * center, const float * positions, const size_t stride,
+                                  const unsigned int * indices, const size_t count)
+{
+  float farthest = 0.f;
+
+  for(size_t i = 0; i < count; ++i) {
+    const float * point = point_at(positions, stride, indices, i);
+    const float offset[3] = { point[0] - center[0], point[1] - center[1], point[2] - center[2] };
+
+    farthest = std::max(farthest, offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+  }
+
+  return farthest;
+}
+
+#endif
+
+void fit_sphere(Bounds & bounds, const float * positions, const size_t stride, const unsigned int * indices, const size_t count)
+{
+  if(bounds.empty()) {
+    return;
+  }
+
+  for(int k = 0; k < 3; ++k) {
+    bounds.center[k] = (bounds.min[k] + bounds.max[k]) * 0.5f;
+  }
+
+  bounds.radius = sqrtf(max_squared_distance(bounds.center, positions, stride, indices, count));
+}
+
+void merge_bounds(Bounds & bounds, const Bounds & other)
+{
+  if(other.empty()) {
+    return;
+  }
+
+  if(bounds.empty()) {
+    bounds = other;
+    return;
+  }
+
+  for(int k = 0; k < 3; ++k) {
+    bounds.min[k] = std::min(bounds.min[k], other.min[k]);
+    bounds.max[k] = std::max(bounds.max[k], other.max[k]);
+  }
+
+  const float offset[3] = { other.center[0] - bounds.center[0], other.center[1] - bounds.center[1],
+                            other.center[2] - bounds.center[2] };
+  const float distance = sqrtf(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+
+  if(distance + other.radius <= bounds.radius) {
+    return;
+  }
+
+  if(distance + bounds.radius <= other.radius) {
+    std::copy(other.center, other.center + 3, bounds.center);
+    bounds.radius = other.radius;
+    return;
+  }
+
+  const float radius = (distance + bounds.radius + other.radius) * 0.5f;
+
+  for(int k = 0; k < 3; ++k) {
+    bounds.center[k] += offset[k] * (radius - bounds.radius) / distance;
+  }
+
+  bounds.radius = radius;
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXBOUNDS_H_
+#define FBX2JSON_FBXBOUNDS_H_
+
+#include <cstddef>
+
+namespace Fbx2Json
+{
+
+// Axis-aligned box and bounding sphere of a set of points. Bounds holding
+// no points yet have `min` above `max` and a negative radius.
+struct Bounds {
+  Bounds();
+  bool empty() const {
+    return min[0] > max[0];
+  }
+
+  float min[3];
+  float max[3];
+  float center[3];
+  float radius;
+};
+
+// The functions below read points as XYZ followed by at least one more float,
+// `stride` floats apart (4 or more), as vertex positions are stored. Point i
+// is positions[indices[i] * stride], or positions[i * stride] when `indices`
+// is NULL. SSE code handles them where the build allows it.
+
+// Grows the box to hold `count` more points; the sphere is left alone.
+void add_points(Bounds & bounds, const float * positions, size_t stride, const unsigned int * indices, size_t count);
+
+// Centres the sphere on the box and makes it just large enough to hold the
+// points, which should be those the box was built from.
+void fit_sphere(Bounds & bounds, const float * positions, size_t stride, const unsigned int * indices, size_t count);
+
+// Grows `bounds` to hold `other` too. The sphere becomes the smallest one
+// holding both spheres.
+void merge_bounds(Bounds & bounds, const Bounds & other);
+
+} // namespace Fbx2Json
+
+#endif
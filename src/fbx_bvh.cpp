@@ -0,0 +1,296 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include "fbx_bvh.h"
+
+namespace Fbx2Json
+{
+
+static const int BVH_BIN_COUNT = 16;
+
+// Cost of visiting a node relative to testing one triangle.
+static const float BVH_TRAVERSAL_COST = 1.f;
+
+// Nodes this deep or deeper are split at the median, which halves their
+// triangles at every level and so keeps the deepest leaf under MAX_BVH_DEPTH
+// for any mesh that fits 32-bit indices.
+static const size_t BVH_MEDIAN_DEPTH = MAX_BVH_DEPTH - 33;
+
+// A triangle's box and centroid, kept together for the partitioning passes.
+struct BvhItem {
+  float min[3];
+  float max[3];
+  float centroid[3];
+  unsigned int triangle;
+};
+
+struct BvhBox {
+  BvhBox() {
+    for(int k = 0; k < 3; ++k) {
+      min[k] = FLT_MAX;
+      max[k] = -FLT_MAX;
+    }
+  }
+
+  void add(const float * item_min, const float * item_max) {
+    for(int k = 0; k < 3; ++k) {
+      min[k] = item_min[k] < min[k] ? item_min[k] : min[k];
+      max[k] = item_max[k] > max[k] ? item_max[k] : max[k];
+    }
+  }
+
+  // Half the surface area, which is all the heuristic needs. Empty boxes
+  // count as 0.
+  float area() const {
+    if(min[0] > max[0]) {
+      return 0.f;
+    }
+
+    const float x = max[0] - min[0];
+    const float y = max[1] - min[1];
+    const float z = max[2] - min[2];
+    return x * y + y * z + z * x;
+  }
+
+  float min[3];
+  float max[3];
+};
+
+struct BvhBin {
+  BvhBin() : count(0) {}
+  BvhBox box;
+  size_t count;
+};
+
+// Sends items to the side of the split they belong to.
+struct BvhBinLess {
+  BvhBinLess(int axis, float origin, float scale, int bin_count, int split) :
+    axis(axis), origin(origin), scale(scale), bin_count(bin_count), split(split) {}
+
+  bool operator()(const BvhItem & item) const {
+    return bin_of(item.centroid[axis], origin, scale, bin_count) < split;
+  }
+
+  static int bin_of(float centroid, float origin, float scale, int bin_count) {
+    const int bin = static_cast<int>((centroid - origin) * scale);
+    return std::min(std::max(bin, 0), bin_count - 1);
+  }
+
+  int axis;
+  float origin;
+  float scale;
+  int bin_count;
+  int split;
+};
+
+struct BvhCentroidLess {
+  explicit BvhCentroidLess(int axis) : axis(axis) {}
+
+  bool operator()(const BvhItem & a, const BvhItem & b) const {
+    return a.centroid[axis] < b.centroid[axis];
+  }
+
+  int axis;
+};
+
+// Finds the cheapest binned split of items [first, last), whose centroids
+// lie in `centroids`, binning along all three axes in one pass. Small nodes
+// get as many bins as items, which is where most of the calls go. Returns
+// false when no split beats keeping the items in one leaf, or the centroids
+// all coincide.
+static bool find_bvh_split(const std::vector<BvhItem> & items, size_t first, size_t last, const BvhBox & box,
+                           const BvhBox & centroids, BvhBinLess & best)
+{
+  const size_t count = last - first;
+  const int bin_count = static_cast<int>(std::min(count, static_cast<size_t>(BVH_BIN_COUNT)));
+  float scales[3];
+
+  for(int axis = 0; axis < 3; ++axis) {
+    const float extent = centroids.max[axis] - centroids.min[axis];
+    scales[axis] = extent > 0.f ? bin_count / extent : 0.f;
+  }
+
+  BvhBin bins[3][BVH_BIN_COUNT];
+
+  for(size_t i = first; i < last; ++i) {
+    const BvhItem & item = items[i];
+
+    for(int axis = 0; axis < 3; ++axis) {
+      BvhBin & bin = bins[axis][BvhBinLess::bin_of(item.centroid[axis], centroids.min[axis], scales[axis], bin_count)];
+      bin.box.add(item.min, item.max);
+      bin.count += 1;
+    }
+  }
+
+  const float inverse_area = box.area() > 0.f ? 1.f / box.area() : 0.f;
+  float best_cost = count <= MAX_BVH_LEAF_TRIANGLES ? static_cast<float>(count) : FLT_MAX;
+  bool found = false;
+
+  for(int axis = 0; axis < 3; ++axis) {
+    if(scales[axis] == 0.f) {
+      continue;
+    }
+
+    // Sweep from the right to get the cost of everything past each split,
+    // then from the left to add the rest.
+    float right_costs[BVH_BIN_COUNT];
+    BvhBox right;
+    size_t right_count = 0;
+
+    for(int b = bin_count - 1; b > 0; --b) {
+      right.add(bins[axis][b].box.min, bins[axis][b].box.max);
+      right_count += bins[axis][b].count;
+      right_costs[b] = right.area() * right_count;
+    }
+
+    BvhBox left;
+    size_t left_count = 0;
+
+    for(int b = 1; b < bin_count; ++b) {
+      left.add(bins[axis][b - 1].box.min, bins[axis][b - 1].box.max);
+      left_count += bins[axis][b - 1].count;
+
+      if(left_count == 0 || left_count == count) {
+        continue;
+      }
+
+      const float cost = BVH_TRAVERSAL_COST + (left.area() * left_count + right_costs[b]) * inverse_area;
+
+      if(cost < best_cost) {
+        best_cost = cost;
+        best = BvhBinLess(axis, centroids.min[axis], scales[axis], bin_count, b);
+        found = true;
+      }
+    }
+  }
+
+  return found;
+}
+
+// Appends the subtree over items [first, last) in depth-first order.
+static void build_bvh_node(std::vector<BvhNode> & nodes, std::vector<BvhItem> & items, size_t first, size_t last,
+                           size_t depth)
+{
+  const size_t index = nodes.size();
+  BvhBox box;
+  BvhBox centroids;
+
+  for(size_t i = first; i < last; ++i) {
+    box.add(items[i].min, items[i].max);
+    centroids.add(items[i].centroid, items[i].centroid);
+  }
+
+  BvhNode node;
+
+  for(int k = 0; k < 3; ++k) {
+    node.min[k] = box.min[k];
+    node.max[k] = box.max[k];
+  }
+
+  node.offset = static_cast<unsigned int>(first);
+  node.count = static_cast<unsigned int>(last - first);
+  nodes.push_back(node);
+
+  if(last - first <= 1) {
+    return;
+  }
+
+  size_t middle = first;
+
+  if(depth < BVH_MEDIAN_DEPTH) {
+    BvhBinLess split(0, 0.f, 0.f, 1, 0);
+
+    if(find_bvh_split(items, first, last, box, centroids, split)) {
+      middle = std::partition(items.begin() + first, items.begin() + last, split) - items.begin();
+    } else if(last - first <= MAX_BVH_LEAF_TRIANGLES) {
+      return;
+    }
+  } else if(last - first <= MAX_BVH_LEAF_TRIANGLES) {
+    return;
+  }
+
+  // Too deep for the heuristic, or too many triangles with one centroid:
+  // halve the items along the longest axis of their centroids.
+  if(middle == first) {
+    const float extent[3] = {
+      centroids.max[0] - centroids.min[0], centroids.max[1] - centroids.min[1], centroids.max[2] - centroids.min[2]
+    };
+    const int axis = extent[0] >= extent[1] && extent[0] >= extent[2] ? 0 : extent[1] >= extent[2] ? 1 : 2;
+    middle = first + (last - first) / 2;
+    std::nth_element(items.begin() + first, items.begin() + middle, items.begin() + last, BvhCentroidLess(axis));
+  }
+
+  build_bvh_node(nodes, items, first, middle, depth + 1);
+  nodes[index].offset = static_cast<unsigned int>(nodes.size());
+  nodes[index].count = 0;
+  build_bvh_node(nodes, items, middle, last, depth + 1);
+}
+
+void build_bvh(std::vector<BvhNode> & nodes, std::vector<unsigned int> & triangles, const unsigned int * indices,
+               size_t index_count, const float * positions, size_t position_stride)
+{
+  std::vector<BvhItem> items;
+  items.reserve(index_count / 3);
+
+  for(size_t t = 0; t < index_count / 3; ++t) {
+    const unsigned int * triangle = indices + t * 3;
+
+    if(triangle[0] == triangle[1] || triangle[0] == triangle[2] || triangle[1] == triangle[2]) {
+      continue;
+    }
+
+    BvhItem item;
+
+    for(int k = 0; k < 3; ++k) {
+      const float a = positions[triangle[0] * position_stride + k];
+      const float b = positions[triangle[1] * position_stride + k];
+      const float c = positions[triangle[2] * position_stride + k];
+      item.min[k] = std::min(a, std::min(b, c));
+      item.max[k] = std::max(a, std::max(b, c));
+      item.centroid[k] = (a + b + c) * (1.f / 3.f);
+    }
+
+    item.triangle = static_cast<unsigned int>(t);
+    items.push_back(item);
+  }
+
+  nodes.clear();
+  triangles.clear();
+
+  if(items.empty()) {
+    return;
+  }
+
+  // A binary tree with at least one triangle per leaf.
+  nodes.reserve(items.size() * 2 - 1);
+  build_bvh_node(nodes, items, 0, items.size(), 0);
+
+  triangles.resize(items.size());
+
+  for(size_t i = 0; i < items.size(); ++i) {
+    triangles[i] = items[i].triangle;
+  }
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXBVH_H_
+#define FBX2JSON_FBXBVH_H_
+
+#include <cstddef>
+#include <vector>
+#include "fbx_bvh_query.h"
+
+namespace Fbx2Json
+{
+
+// Most triangles a leaf holds.
+const size_t MAX_BVH_LEAF_TRIANGLES = 4;
+
+// Builds the hierarchy described in fbx_bvh_query.h over a triangle list,
+// replacing the contents of `nodes` and `triangles`. Each node is split where
+// the surface area heuristic, evaluated over 16 bins of triangle centroids
+// along each axis, predicts the cheapest ray queries, until a split would not
+// pay off and at most MAX_BVH_LEAF_TRIANGLES triangles are left. Nodes
+// nearing MAX_BVH_DEPTH are split at the median instead. Triangles repeating
+// a vertex are left out.
+//
+// `positions` holds three floats per vertex, `position_stride` floats apart.
+void build_bvh(std::vector<BvhNode> & nodes, std::vector<unsigned int> & triangles, const unsigned int * indices,
+               size_t index_count, const float * positions, size_t position_stride);
+
+} // namespace Fbx2Json
+
+#endif
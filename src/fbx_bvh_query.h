@@ -0,0 +1,217 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXBVHQUERY_H_
+#define FBX2JSON_FBXBVHQUERY_H_
+
+#include <cstddef>
+
+namespace Fbx2Json
+{
+
+// Bounding volume hierarchy over a mesh's triangles, as the binary output
+// stores it. Like fbx_codec.h this header has no dependency on the FBX SDK,
+// and is all a loader needs to query what we write.
+//
+// Nodes are 32 bytes and stored depth first, so the first child of an inner
+// node is the node right after it. Leaves have a non-zero `count` and hold
+// the triangles listed at entries `offset` to `offset + count` of the
+// triangle table, each a triangle number: triangle t is made of indices 3t
+// to 3t + 2. Inner nodes have a zero `count` and `offset` is their second
+// child. The first node is the root; a mesh without triangles has no nodes.
+struct BvhNode {
+  float min[3];
+  unsigned int offset;
+  float max[3];
+  unsigned int count;
+};
+
+// Longest path from the root to a leaf the builder produces, which bounds
+// the traversal stack.
+const size_t MAX_BVH_DEPTH = 64;
+
+struct BvhHit {
+  // Triangle number, and the ray's parameter at the hit: the hit point is
+  // origin + distance * direction. The barycentric coordinates of the point
+  // are (1 - u - v, u, v) for the triangle's three corners.
+  unsigned int triangle;
+  float distance;
+  float u;
+  float v;
+};
+
+// Distance along the ray to the box of `node`, or a negative value when the
+// ray misses it or only meets it beyond `max_distance`.
+inline float intersect_bvh_node(const BvhNode & node, const float * origin, const float * inverse_direction,
+                                float max_distance)
+{
+  float near_distance = 0.f;
+  float far_distance = max_distance;
+
+  for(int k = 0; k < 3; ++k) {
+    float t0 = (node.min[k] - origin[k]) * inverse_direction[k];
+    float t1 = (node.max[k] - origin[k]) * inverse_direction[k];
+
+    if(t0 > t1) {
+      const float t = t0;
+      t0 = t1;
+      t1 = t;
+    }
+
+    // Written so that NaNs, from a ray lying in a face of the box, leave the
+    // interval alone.
+    near_distance = t0 > near_distance ? t0 : near_distance;
+    far_distance = t1 < far_distance ? t1 : far_distance;
+  }
+
+  return near_distance <= far_distance ? near_distance : -1.f;
+}
+
+// Ray against triangle, both sides counted (Moller-Trumbore). Returns whether
+// the ray meets it closer than `hit.distance`, updating `hit` if so.
+inline bool intersect_bvh_triangle(const float * a, const float * b, const float * c, const float * origin,
+                                   const float * direction, unsigned int triangle, BvhHit & hit)
+{
+  const float edge1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+  const float edge2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+  const float p[3] = {
+    direction[1] * edge2[2] - direction[2] * edge2[1],
+    direction[2] * edge2[0] - direction[0] * edge2[2],
+    direction[0] * edge2[1] - direction[1] * edge2[0]
+  };
+  const float determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+
+  if(determinant == 0.f) {
+    return false;
+  }
+
+  const float inverse = 1.f / determinant;
+  const float s[3] = { origin[0] - a[0], origin[1] - a[1], origin[2] - a[2] };
+  const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+
+  if(u < 0.f || u > 1.f) {
+    return false;
+  }
+
+  const float q[3] = { s[1] * edge1[2] - s[2] * edge1[1], s[2] * edge1[0] - s[0] * edge1[2], s[0] * edge1[1] - s[1] * edge1[0] };
+  const float v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverse;
+
+  if(v < 0.f || u + v > 1.f) {
+    return false;
+  }
+
+  const float distance = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) * inverse;
+
+  if(distance < 0.f || distance >= hit.distance) {
+    return false;
+  }
+
+  hit.triangle = triangle;
+  hit.distance = distance;
+  hit.u = u;
+  hit.v = v;
+  return true;
+}
+
+// Finds the closest triangle the ray from `origin` along `direction` meets
+// within `max_distance` (in units of `direction`, which need not be
+// normalised). `Index` is unsigned short or unsigned int, as in the mesh's
+// index array, and `positions` holds three floats per vertex, `stride`
+// floats apart (4 for the binary output's vertices). With `any_hit` the
+// search stops at the first triangle met, for occlusion tests. Returns
+// whether a triangle was met.
+template <typename Index>
+bool raycast_bvh(const BvhNode * nodes, size_t node_count, const unsigned int * triangles, const Index * indices,
+                 const float * positions, size_t stride, const float * origin, const float * direction,
+                 float max_distance, BvhHit & hit, bool any_hit = false)
+{
+  hit.triangle = ~0u;
+  hit.distance = max_distance;
+  hit.u = hit.v = 0.f;
+
+  if(node_count == 0) {
+    return false;
+  }
+
+  const float inverse_direction[3] = { 1.f / direction[0], 1.f / direction[1], 1.f / direction[2] };
+
+  if(intersect_bvh_node(nodes[0], origin, inverse_direction, max_distance) < 0.f) {
+    return false;
+  }
+
+  unsigned int stack[MAX_BVH_DEPTH];
+  size_t stack_size = 0;
+  unsigned int current = 0;
+
+  for(;;) {
+    const BvhNode & node = nodes[current];
+
+    if(node.count > 0) {
+      for(unsigned int i = node.offset; i < node.offset + node.count; ++i) {
+        const Index * triangle = indices + triangles[i] * 3;
+
+        if(intersect_bvh_triangle(positions + triangle[0] * stride, positions + triangle[1] * stride,
+                                  positions + triangle[2] * stride, origin, direction, triangles[i], hit) && any_hit) {
+          return true;
+        }
+      }
+    } else {
+      // Visit the nearer child first, so farther boxes get culled by the
+      // closest hit found so far.
+      const unsigned int first = current + 1;
+      const unsigned int second = node.offset;
+      const float first_distance = intersect_bvh_node(nodes[first], origin, inverse_direction, hit.distance);
+      const float second_distance = intersect_bvh_node(nodes[second], origin, inverse_direction, hit.distance);
+
+      if(first_distance >= 0.f && second_distance >= 0.f) {
+        const bool first_nearer = first_distance <= second_distance;
+        stack[stack_size++] = first_nearer ? second : first;
+        current = first_nearer ? first : second;
+        continue;
+      } else if(first_distance >= 0.f) {
+        current = first;
+        continue;
+      } else if(second_distance >= 0.f) {
+        current = second;
+        continue;
+      }
+    }
+
+    // Pop until a node is still closer than the best hit.
+    bool found = false;
+
+    while(stack_size > 0 && !found) {
+      current = stack[--stack_size];
+      found = intersect_bvh_node(nodes[current], origin, inverse_direction, hit.distance) >= 0.f;
+    }
+
+    if(!found) {
+      break;
+    }
+  }
+
+  return hit.triangle != ~0u;
+}
+
+} // namespace Fbx2Json
+
+#endif
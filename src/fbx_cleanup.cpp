@@ -0,0 +1,145 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "fbx_cleanup.h"
+
+namespace Fbx2Json
+{
+
+// A triangle counts as zero-area when its height is under this fraction of
+// the larger of its longest edge and its distance from the origin: two
+// float32 roundings of its coordinates, which can be all that separates
+// corners that were collinear in the file.
+static const double DEGENERATE_HEIGHT_EPSILON = 2.0 * FLT_EPSILON;
+
+// A triangle's points rotated to start with the lowest, which keeps the
+// winding, and its position in the list so that the first copy is kept.
+struct TriangleKey {
+  unsigned int points[3];
+  unsigned int triangle;
+
+  bool operator<(const TriangleKey & other) const {
+    for(int k = 0; k < 3; ++k) {
+      if(points[k] != other.points[k]) {
+        return points[k] < other.points[k];
+      }
+    }
+
+    return triangle < other.triangle;
+  }
+
+  bool same_points(const TriangleKey & other) const {
+    return points[0] == other.points[0] && points[1] == other.points[1] && points[2] == other.points[2];
+  }
+};
+
+// Products of floats are exact in double, so exactly collinear corners give
+// an exactly zero cross product.
+static bool has_zero_area(const float * a, const float * b, const float * c)
+{
+  const double ab[3] = { double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2] };
+  const double ac[3] = { double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2] };
+  const double bc[3] = { double(c[0]) - b[0], double(c[1]) - b[1], double(c[2]) - b[2] };
+  const double cross[3] = {
+    ab[1] * ac[2] - ab[2] * ac[1],
+    ab[2] * ac[0] - ab[0] * ac[2],
+    ab[0] * ac[1] - ab[1] * ac[0]
+  };
+
+  // Twice the area is the longest edge times the height over it.
+  const double longest = std::sqrt(std::max(ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2],
+                                            std::max(ac[0] * ac[0] + ac[1] * ac[1] + ac[2] * ac[2],
+                                                     bc[0] * bc[0] + bc[1] * bc[1] + bc[2] * bc[2])));
+  double scale = longest;
+
+  for(int k = 0; k < 3; ++k) {
+    scale = std::max(scale, double(std::max(std::fabs(a[k]), std::max(std::fabs(b[k]), std::fabs(c[k])))));
+  }
+
+  const double twice_area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+  return twice_area <= DEGENERATE_HEIGHT_EPSILON * scale * longest;
+}
+
+size_t remove_degenerate_triangles(unsigned int * indices, size_t index_count, const unsigned int * points,
+                                   const float * positions, size_t position_stride, CleanupResult & result)
+{
+  const size_t triangle_count = index_count / 3;
+  std::vector<unsigned char> removed(triangle_count, 0);
+  std::vector<TriangleKey> keys;
+  keys.reserve(triangle_count);
+
+  for(size_t t = 0; t < triangle_count; ++t) {
+    const unsigned int * triangle = indices + t * 3;
+    const unsigned int a = points[triangle[0]];
+    const unsigned int b = points[triangle[1]];
+    const unsigned int c = points[triangle[2]];
+
+    if(a == b || a == c || b == c ||
+       (positions != NULL && has_zero_area(positions + triangle[0] * position_stride,
+                                           positions + triangle[1] * position_stride,
+                                           positions + triangle[2] * position_stride))) {
+      removed[t] = 1;
+      result.degenerate_triangles += 1;
+      continue;
+    }
+
+    const int first = a < b ? (a < c ? 0 : 2) : (b < c ? 1 : 2);
+    const unsigned int corners[3] = { a, b, c };
+    TriangleKey key;
+
+    for(int k = 0; k < 3; ++k) {
+      key.points[k] = corners[(first + k) % 3];
+    }
+
+    key.triangle = static_cast<unsigned int>(t);
+    keys.push_back(key);
+  }
+
+  std::sort(keys.begin(), keys.end());
+
+  for(size_t i = 1; i < keys.size(); ++i) {
+    if(keys[i].same_points(keys[i - 1])) {
+      removed[keys[i].triangle] = 1;
+      result.duplicate_triangles += 1;
+    }
+  }
+
+  size_t kept = 0;
+
+  for(size_t t = 0; t < triangle_count; ++t) {
+    if(!removed[t]) {
+      for(int k = 0; k < 3; ++k) {
+        indices[kept * 3 + k] = indices[t * 3 + k];
+      }
+
+      kept += 1;
+    }
+  }
+
+  return kept * 3;
+}
+
+} // namespace Fbx2Json
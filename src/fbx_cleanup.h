@@ -0,0 +1,58 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXCLEANUP_H_
+#define FBX2JSON_FBXCLEANUP_H_
+
+#include <cstddef>
+
+namespace Fbx2Json
+{
+
+// What cleaning up a mesh removed.
+struct CleanupResult {
+  CleanupResult() : degenerate_triangles(0), duplicate_triangles(0), unused_vertices(0) {}
+
+  size_t degenerate_triangles;
+  size_t duplicate_triangles;
+  size_t unused_vertices;
+};
+
+// Removes, in place and keeping the order of the rest, the triangles of an
+// index list that cover nothing or that were drawn already:
+//
+// * triangles with two corners on the same point,
+// * with `positions`, triangles whose height is negligible next to their
+//   size and position, such as those fanned across collinear polygon edges,
+// * triangles repeating an earlier one on the same points with the same
+//   winding. Opposite windings are kept, as they make double-sided faces.
+//
+// `points` maps each vertex to a point, vertices sharing one being in the
+// same place whatever the pose. `positions`, which may be NULL to skip the
+// area test, holds three floats per vertex, `position_stride` floats apart.
+// Adds what was removed to `result` and returns the new index count.
+size_t remove_degenerate_triangles(unsigned int * indices, size_t index_count, const unsigned int * points,
+                                   const float * positions, size_t position_stride, CleanupResult & result);
+
+} // namespace Fbx2Json
+
+#endif
@@ -0,0 +1,365 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include "fbx_codec.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FBX2JSON_CODEC_SSE2
+#endif
+
+namespace Fbx2Json
+{
+
+const size_t GROUP_SIZE = 16;
+
+// Bits per byte for each 2-bit group header code.
+const int GROUP_BITS[4] = { 0, 2, 4, 8 };
+
+// Zigzag encoding works on the two's complement bits of a delta, with
+// unsigned arithmetic throughout so that no negative value is shifted.
+static inline unsigned int zigzag(const unsigned int delta)
+{
+  return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+static inline int unzigzag(const unsigned int value)
+{
+  return static_cast<int>((value >> 1) ^ (0u - (value & 1)));
+}
+
+static inline unsigned char zigzag8(const unsigned char delta)
+{
+  return static_cast<unsigned char>((delta << 1) ^ (0u - (delta >> 7)));
+}
+
+static inline unsigned char unzigzag8(const unsigned char value)
+{
+  return static_cast<unsigned char>((value >> 1) ^ (0u - (value & 1)));
+}
+
+template <typename T>
+static void encode_indices(std::vector<unsigned char> & buffer, const T * indices, size_t index_count)
+{
+  buffer.push_back(INDEX_CODEC_VERSION);
+
+  unsigned int previous = 0;
+
+  for(size_t i = 0; i < index_count; ++i) {
+    unsigned int value = zigzag(static_cast<unsigned int>(indices[i]) - previous);
+    previous = indices[i];
+
+    while(value >= 0x80) {
+      buffer.push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+    }
+
+    buffer.push_back(static_cast<unsigned char>(value));
+  }
+}
+
+template <typename T>
+static bool decode_indices(T * destination, size_t index_count, const unsigned char * buffer, size_t buffer_size)
+{
+  if(buffer_size < 1 || buffer[0] != INDEX_CODEC_VERSION) {
+    return false;
+  }
+
+  const unsigned char * data = buffer + 1;
+  const unsigned char * end = buffer + buffer_size;
+  unsigned int previous = 0;
+
+  for(size_t i = 0; i < index_count; ++i) {
+    if(data == end) {
+      return false;
+    }
+
+    unsigned int value = *data++;
+
+    // Deltas are mostly single bytes, keep that path free of the loop.
+    if(value >= 0x80) {
+      value &= 0x7f;
+
+      for(int shift = 7; ; shift += 7) {
+        if(data == end || shift > 28) {
+          return false;
+        }
+
+        const unsigned int byte = *data++;
+        value |= (byte & 0x7f) << shift;
+
+        if(byte < 0x80) {
+          break;
+        }
+      }
+    }
+
+    previous += static_cast<unsigned int>(unzigzag(value));
+    destination[i] = static_cast<T>(previous);
+  }
+
+  return data == end;
+}
+
+void encode_index_buffer(std::vector<unsigned char> & buffer, const unsigned int * indices, size_t index_count)
+{
+  encode_indices(buffer, indices, index_count);
+}
+
+void encode_index_buffer(std::vector<unsigned char> & buffer, const unsigned short * indices, size_t index_count)
+{
+  encode_indices(buffer, indices, index_count);
+}
+
+bool decode_index_buffer(unsigned int * destination, size_t index_count, const unsigned char * buffer, size_t buffer_size)
+{
+  return decode_indices(destination, index_count, buffer, buffer_size);
+}
+
+bool decode_index_buffer(unsigned short * destination, size_t index_count, const unsigned char * buffer, size_t buffer_size)
+{
+  return decode_indices(destination, index_count, buffer, buffer_size);
+}
+
+static int group_code(const unsigned char * group)
+{
+  unsigned char bits = 0;
+
+  for(size_t i = 0; i < GROUP_SIZE; ++i) {
+    bits |= group[i];
+  }
+
+  if(bits == 0) {
+    return 0;
+  } else if(bits < 4) {
+    return 1;
+  } else if(bits < 16) {
+    return 2;
+  }
+
+  return 3;
+}
+
+static void encode_group(std::vector<unsigned char> & buffer, const unsigned char * group, const int code)
+{
+  const int bits = GROUP_BITS[code];
+
+  if(bits == 0) {
+    return;
+  } else if(bits == 8) {
+    buffer.insert(buffer.end(), group, group + GROUP_SIZE);
+    return;
+  }
+
+  const size_t per_byte = 8 / bits;
+
+  for(size_t i = 0; i < GROUP_SIZE; i += per_byte) {
+    unsigned char packed = 0;
+
+    for(size_t j = 0; j < per_byte; ++j) {
+      packed |= static_cast<unsigned char>(group[i + j] << (j * bits));
+    }
+
+    buffer.push_back(packed);
+  }
+}
+
+static void encode_vertex_block(std::vector<unsigned char> & buffer, const unsigned char * vertices, size_t vertex_count,
+                                size_t vertex_size, unsigned char * last_vertex)
+{
+  const size_t group_count = (vertex_count + GROUP_SIZE - 1) / GROUP_SIZE;
+  unsigned char plane[VERTEX_BLOCK_SIZE];
+
+  for(size_t k = 0; k < vertex_size; ++k) {
+    unsigned char previous = last_vertex[k];
+
+    for(size_t i = 0; i < vertex_count; ++i) {
+      const unsigned char value = vertices[i * vertex_size + k];
+      plane[i] = zigzag8(static_cast<unsigned char>(value - previous));
+      previous = value;
+    }
+
+    memset(plane + vertex_count, 0, group_count * GROUP_SIZE - vertex_count);
+
+    const size_t header_offset = buffer.size();
+    buffer.resize(buffer.size() + (group_count + 3) / 4, 0);
+
+    for(size_t g = 0; g < group_count; ++g) {
+      const int code = group_code(plane + g * GROUP_SIZE);
+      buffer[header_offset + g / 4] |= static_cast<unsigned char>(code << ((g % 4) * 2));
+      encode_group(buffer, plane + g * GROUP_SIZE, code);
+    }
+
+    last_vertex[k] = previous;
+  }
+}
+
+void encode_vertex_buffer(std::vector<unsigned char> & buffer, const void * vertices, size_t vertex_count, size_t vertex_size)
+{
+  buffer.push_back(VERTEX_CODEC_VERSION);
+
+  const unsigned char * data = static_cast<const unsigned char *>(vertices);
+  unsigned char last_vertex[MAX_VERTEX_SIZE] = { 0 };
+
+  for(size_t start = 0; start < vertex_count; start += VERTEX_BLOCK_SIZE) {
+    const size_t count = vertex_count - start < VERTEX_BLOCK_SIZE ? vertex_count - start : VERTEX_BLOCK_SIZE;
+    encode_vertex_block(buffer, data + start * vertex_size, count, vertex_size, last_vertex);
+  }
+}
+
+#ifdef FBX2JSON_CODEC_SSE2
+
+static inline __m128i unpack_group(const unsigned char * data, const int code)
+{
+  switch(code) {
+    case 0:
+      return _mm_setzero_si128();
+
+    case 1: {
+      int packed;
+      memcpy(&packed, data, sizeof(packed));
+      const __m128i bytes = _mm_cvtsi32_si128(packed);
+      const __m128i mask = _mm_set1_epi8(3);
+      const __m128i b0 = _mm_and_si128(bytes, mask);
+      const __m128i b1 = _mm_and_si128(_mm_srli_epi16(bytes, 2), mask);
+      const __m128i b2 = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+      const __m128i b3 = _mm_and_si128(_mm_srli_epi16(bytes, 6), mask);
+      return _mm_unpacklo_epi16(_mm_unpacklo_epi8(b0, b1), _mm_unpacklo_epi8(b2, b3));
+    }
+
+    case 2: {
+      const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data));
+      const __m128i mask = _mm_set1_epi8(15);
+      return _mm_unpacklo_epi8(_mm_and_si128(bytes, mask), _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+    }
+
+    default:
+      return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+  }
+}
+
+// Unpacks a group, undoes the zigzag and turns the 16 deltas into absolute
+// bytes with a log-step prefix sum. Returns the last byte of the group.
+static inline unsigned char decode_group(const unsigned char * data, const int code, unsigned char previous, unsigned char * group)
+{
+  const __m128i value = unpack_group(data, code);
+  const __m128i halved = _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi8(0x7f));
+  const __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi8(1)));
+  __m128i sum = _mm_xor_si128(halved, sign);
+
+  sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 1));
+  sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 2));
+  sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 4));
+  sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 8));
+  sum = _mm_add_epi8(sum, _mm_set1_epi8(static_cast<char>(previous)));
+
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(group), sum);
+
+  return group[GROUP_SIZE - 1];
+}
+
+#else
+
+static inline unsigned char decode_group(const unsigned char * data, const int code, unsigned char previous, unsigned char * group)
+{
+  const int bits = GROUP_BITS[code];
+  const unsigned char mask = static_cast<unsigned char>((1 << bits) - 1);
+
+  for(size_t i = 0; i < GROUP_SIZE; ++i) {
+    unsigned char value = 0;
+
+    if(bits == 8) {
+      value = data[i];
+    } else if(bits > 0) {
+      const size_t per_byte = 8 / bits;
+      value = (data[i / per_byte] >> ((i % per_byte) * bits)) & mask;
+    }
+
+    previous = static_cast<unsigned char>(previous + unzigzag8(value));
+    group[i] = previous;
+  }
+
+  return previous;
+}
+
+#endif
+
+bool decode_vertex_buffer(void * destination, size_t vertex_count, size_t vertex_size, const unsigned char * buffer, size_t buffer_size)
+{
+  if(buffer_size < 1 || buffer[0] != VERTEX_CODEC_VERSION || vertex_size == 0 || vertex_size > MAX_VERTEX_SIZE) {
+    return false;
+  }
+
+  unsigned char * output = static_cast<unsigned char *>(destination);
+  const unsigned char * data = buffer + 1;
+  const unsigned char * end = buffer + buffer_size;
+  unsigned char last_vertex[MAX_VERTEX_SIZE] = { 0 };
+  std::vector<unsigned char> planes(MAX_VERTEX_SIZE * VERTEX_BLOCK_SIZE);
+
+  for(size_t start = 0; start < vertex_count; start += VERTEX_BLOCK_SIZE) {
+    const size_t count = vertex_count - start < VERTEX_BLOCK_SIZE ? vertex_count - start : VERTEX_BLOCK_SIZE;
+    const size_t group_count = (count + GROUP_SIZE - 1) / GROUP_SIZE;
+
+    for(size_t k = 0; k < vertex_size; ++k) {
+      const unsigned char * header = data;
+      unsigned char * plane = &planes[k * VERTEX_BLOCK_SIZE];
+      data += (group_count + 3) / 4;
+
+      if(data > end) {
+        return false;
+      }
+
+      unsigned char previous = last_vertex[k];
+
+      for(size_t g = 0; g < group_count; ++g) {
+        const int code = (header[g / 4] >> ((g % 4) * 2)) & 3;
+        const size_t size = GROUP_BITS[code] * 2;
+
+        if(static_cast<size_t>(end - data) < size) {
+          return false;
+        }
+
+        previous = decode_group(data, code, previous, plane + g * GROUP_SIZE);
+        data += size;
+      }
+
+      last_vertex[k] = plane[count - 1];
+    }
+
+    // Interleave the planes back into vertices; the output is written
+    // sequentially.
+    unsigned char * vertex = output + start * vertex_size;
+
+    for(size_t i = 0; i < count; ++i) {
+      for(size_t k = 0; k < vertex_size; ++k) {
+        vertex[k] = planes[k * VERTEX_BLOCK_SIZE + i];
+      }
+
+      vertex += vertex_size;
+    }
+  }
+
+  return data == end;
+}
+
+} // namespace Fbx2Json
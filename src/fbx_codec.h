@@ -0,0 +1,61 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXCODEC_H_
+#define FBX2JSON_FBXCODEC_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace Fbx2Json
+{
+
+// Lossless codecs for the binary output. They have no dependency on the FBX
+// SDK so that loaders can build this file as-is to decode what we write.
+//
+// Index buffers: each index is stored as the zigzag-encoded difference to the
+// previous one in LEB128 varint form. Indices of a cache-optimised mesh are
+// close to each other, so most of them take a single byte.
+//
+// Vertex buffers: vertices are processed in blocks of VERTEX_BLOCK_SIZE. Within
+// a block every byte position of the vertex forms a plane, each byte of which
+// is replaced by the zigzag-encoded difference to the same byte of the
+// previous vertex. Planes are then bit-packed in groups of 16 bytes using 0, 2,
+// 4 or 8 bits per byte, whichever is the smallest that fits the group.
+
+const unsigned char INDEX_CODEC_VERSION = 0xe1;
+const unsigned char VERTEX_CODEC_VERSION = 0xa1;
+const size_t VERTEX_BLOCK_SIZE = 256;
+const size_t MAX_VERTEX_SIZE = 256;
+
+// 16 and 32-bit indices share one encoding.
+void encode_index_buffer(std::vector<unsigned char> & buffer, const unsigned int * indices, size_t index_count);
+void encode_index_buffer(std::vector<unsigned char> & buffer, const unsigned short * indices, size_t index_count);
+bool decode_index_buffer(unsigned int * destination, size_t index_count, const unsigned char * buffer, size_t buffer_size);
+bool decode_index_buffer(unsigned short * destination, size_t index_count, const unsigned char * buffer, size_t buffer_size);
+
+void encode_vertex_buffer(std::vector<unsigned char> & buffer, const void * vertices, size_t vertex_count, size_t vertex_size);
+bool decode_vertex_buffer(void * destination, size_t vertex_count, size_t vertex_size, const unsigned char * buffer, size_t buffer_size);
+
+} // namespace Fbx2Json
+
+#endif
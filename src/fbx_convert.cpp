@@ -0,0 +1,267 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include "fbx_convert.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FBX2JSON_CONVERT_SSE2
+#endif
+
+// AVX kernels are compiled for the target whatever the build flags and only
+// run once the CPU and OS are known to support them.
+#if defined(FBX2JSON_CONVERT_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#include <immintrin.h>
+#define FBX2JSON_CONVERT_AVX
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FBX2JSON_TARGET_AVX
+#else
+#define FBX2JSON_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace Fbx2Json
+{
+
+static inline const double * source_vector(const double * source, const int source_stride, const int * indices, const size_t i)
+{
+  return source + static_cast<size_t>(indices != NULL ? indices[i] : i) * source_stride;
+}
+
+static void convert_vectors_scalar(float * destination, const int destination_stride, const int components,
+                                   const double * source, const int source_stride, const int * indices, const size_t begin,
+                                   const size_t end)
+{
+  for(size_t i = begin; i < end; ++i) {
+    const double * vector = source_vector(source, source_stride, indices, i);
+
+    for(int k = 0; k < components; ++k) {
+      destination[i * destination_stride + k] = static_cast<float>(vector[k]);
+    }
+  }
+}
+
+static void convert_points_scalar(float * destination, const double * source, const int source_stride, const int * indices,
+                                  const size_t begin, const size_t end, float * minimum, float * maximum)
+{
+  convert_vectors_scalar(destination, 4, 3, source, source_stride, indices, begin, end);
+
+  for(size_t i = begin; i < end; ++i) {
+    destination[i * 4 + 3] = 1.f;
+
+    for(int k = 0; k < 3; ++k) {
+      minimum[k] = std::min(minimum[k], destination[i * 4 + k]);
+      maximum[k] = std::max(maximum[k], destination[i * 4 + k]);
+    }
+  }
+}
+
+#ifdef FBX2JSON_CONVERT_SSE2
+
+// Vectors of 2 or 4 values into as many floats. Returns how many vectors were
+// converted, the rest being left to the scalar code.
+static size_t convert_vectors_sse2(float * destination, const int components, const double * source, const int source_stride,
+                                   const int * indices, const size_t count)
+{
+  if(components == 2) {
+    for(size_t i = 0; i < count; ++i) {
+      const __m128 xy = _mm_cvtpd_ps(_mm_loadu_pd(source_vector(source, source_stride, indices, i)));
+      _mm_storel_pi(reinterpret_cast<__m64 *>(destination + i * 2), xy);
+    }
+
+    return count;
+  }
+
+  for(size_t i = 0; i < count; ++i) {
+    const double * vector = source_vector(source, source_stride, indices, i);
+    const __m128 xyzw = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(vector)), _mm_cvtpd_ps(_mm_loadu_pd(vector + 2)));
+    _mm_storeu_ps(destination + i * 4, xyzw);
+  }
+
+  return count;
+}
+
+// The bounds are kept in the W lane too, which store_bounds drops.
+static inline void store_bounds(const __m128 lower, const __m128 upper, float * minimum, float * maximum)
+{
+  float values[4];
+
+  _mm_storeu_ps(values, lower);
+  std::copy(values, values + 3, minimum);
+  _mm_storeu_ps(values, upper);
+  std::copy(values, values + 3, maximum);
+}
+
+static size_t convert_points_sse2(float * destination, const double * source, const int source_stride, const int * indices,
+                                  const size_t count, float * minimum, float * maximum)
+{
+  const __m128 xyz_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  const __m128 w = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
+  __m128 lower = _mm_setr_ps(minimum[0], minimum[1], minimum[2], 1.f);
+  __m128 upper = _mm_setr_ps(maximum[0], maximum[1], maximum[2], 1.f);
+
+  for(size_t i = 0; i < count; ++i) {
+    const double * vector = source_vector(source, source_stride, indices, i);
+    const __m128 xyzw = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(vector)), _mm_cvtpd_ps(_mm_loadu_pd(vector + 2)));
+    const __m128 point = _mm_or_ps(_mm_and_ps(xyzw, xyz_mask), w);
+
+    _mm_storeu_ps(destination + i * 4, point);
+    lower = _mm_min_ps(lower, point);
+    upper = _mm_max_ps(upper, point);
+  }
+
+  store_bounds(lower, upper, minimum, maximum);
+
+  return count;
+}
+
+#endif
+
+#ifdef FBX2JSON_CONVERT_AVX
+
+static bool cpu_has_avx()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+
+  // AVX itself, and OSXSAVE so that the OS state can be checked.
+  const bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0;
+
+  return avx && (_xgetbv(0) & 6) == 6;
+#else
+  return __builtin_cpu_supports("avx");
+#endif
+}
+
+// Two uv pairs or one vector of four per conversion.
+FBX2JSON_TARGET_AVX
+static size_t convert_vectors_avx(float * destination, const int components, const double * source, const int source_stride,
+                                  const int * indices, const size_t count)
+{
+  if(components == 2) {
+    size_t i = 0;
+
+    for(; i + 2 <= count; i += 2) {
+      const __m128d first = _mm_loadu_pd(source_vector(source, source_stride, indices, i));
+      const __m128d second = _mm_loadu_pd(source_vector(source, source_stride, indices, i + 1));
+      const __m256d pair = _mm256_insertf128_pd(_mm256_castpd128_pd256(first), second, 1);
+      _mm_storeu_ps(destination + i * 2, _mm256_cvtpd_ps(pair));
+    }
+
+    return i;
+  }
+
+  for(size_t i = 0; i < count; ++i) {
+    _mm_storeu_ps(destination + i * 4, _mm256_cvtpd_ps(_mm256_loadu_pd(source_vector(source, source_stride, indices, i))));
+  }
+
+  return count;
+}
+
+FBX2JSON_TARGET_AVX
+static size_t convert_points_avx(float * destination, const double * source, const int source_stride, const int * indices,
+                                 const size_t count, float * minimum, float * maximum)
+{
+  const __m128 w = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
+  __m128 lower = _mm_setr_ps(minimum[0], minimum[1], minimum[2], 1.f);
+  __m128 upper = _mm_setr_ps(maximum[0], maximum[1], maximum[2], 1.f);
+
+  for(size_t i = 0; i < count; ++i) {
+    const __m128 xyzw = _mm256_cvtpd_ps(_mm256_loadu_pd(source_vector(source, source_stride, indices, i)));
+    const __m128 point = _mm_blend_ps(xyzw, w, 8);
+
+    _mm_storeu_ps(destination + i * 4, point);
+    lower = _mm_min_ps(lower, point);
+    upper = _mm_max_ps(upper, point);
+  }
+
+  store_bounds(lower, upper, minimum, maximum);
+
+  return count;
+}
+
+#endif
+
+// The vector kernels write exactly `components` floats per vector, so they
+// only run when vectors are packed in both arrays and the source really
+// has the values they load.
+void convert_vectors(float * destination, const int destination_stride, const int components, const double * source,
+                     const int source_stride, const int * indices, const size_t count)
+{
+  size_t converted = 0;
+
+#ifdef FBX2JSON_CONVERT_SSE2
+  const bool packed = destination_stride == components && (components == 2 || components == 4) && source_stride >= components;
+
+  if(packed) {
+#ifdef FBX2JSON_CONVERT_AVX
+    static const bool avx = cpu_has_avx();
+
+    if(avx) {
+      converted = convert_vectors_avx(destination, components, source, source_stride, indices, count);
+    } else
+#endif
+    {
+      converted = convert_vectors_sse2(destination, components, source, source_stride, indices, count);
+    }
+  }
+#endif
+
+  convert_vectors_scalar(destination, destination_stride, components, source, source_stride, indices, converted, count);
+}
+
+void convert_points(float * destination, const double * source, const int source_stride, const int * indices, const size_t count)
+{
+  float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+  convert_points(destination, source, source_stride, indices, count, minimum, maximum);
+}
+
+void convert_points(float * destination, const double * source, const int source_stride, const int * indices, const size_t count,
+                    float * minimum, float * maximum)
+{
+  size_t converted = 0;
+
+#ifdef FBX2JSON_CONVERT_SSE2
+  if(source_stride >= 4) {
+#ifdef FBX2JSON_CONVERT_AVX
+    static const bool avx = cpu_has_avx();
+
+    if(avx) {
+      converted = convert_points_avx(destination, source, source_stride, indices, count, minimum, maximum);
+    } else
+#endif
+    {
+      converted = convert_points_sse2(destination, source, source_stride, indices, count, minimum, maximum);
+    }
+  }
+#endif
+
+  convert_points_scalar(destination, source, source_stride, indices, converted, count, minimum, maximum);
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXCONVERT_H_
+#define FBX2JSON_FBXCONVERT_H_
+
+#include <cstddef>
+
+namespace Fbx2Json
+{
+
+// Bulk conversion of the FBX SDK's double vectors (FbxVector4, FbxVector2,
+// FbxColor, ...) to the floats we export. Vector i is read from source vector
+// indices[i], or from vector i when `indices` is NULL; source vectors are
+// `source_stride` doubles apart. SSE2 and, where the CPU has it, AVX kernels
+// are picked at run time; all give the same results as static_cast<float>.
+
+// Converts the first `components` (2 to 4) values of each vector to floats
+// `destination_stride` apart. Values past `components` are left alone.
+void convert_vectors(float * destination, int destination_stride, int components, const double * source,
+                     int source_stride, const int * indices, size_t count);
+
+// Converts XYZ to XYZW floats with W set to 1, as vertex positions are stored.
+// The second form also grows the box from `minimum` to `maximum` (three
+// floats each) to hold the converted points, in the same pass.
+void convert_points(float * destination, const double * source, int source_stride, const int * indices, size_t count);
+void convert_points(float * destination, const double * source, int source_stride, const int * indices, size_t count,
+                    float * minimum, float * maximum);
+
+} // namespace Fbx2Json
+
+#endif
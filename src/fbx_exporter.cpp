@@ -20,61 +20,683 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <iostream>
+#include "fbx_codec.h"
 #include "fbx_exporter.h"
+#include "fbx_glb_exporter.h"
+#include "fbx_interleave.h"
+#include "fbx_output_file.h"
+#include "fbx_parallel.h"
 
 namespace Fbx2Json
 {
 
+static bool ends_with(const std::string & text, const std::string & suffix)
+{
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// "scene.json" -> "scene.bin", "scene" -> "scene.bin" and, for compressed
+// output, "scene.json.gz" -> "scene.bin.gz". A descriptor that is itself
+// named ".bin" keeps its name and gains the suffix, "scene.bin" ->
+// "scene.bin.bin", so the two files never coincide.
+static std::string sidecar_path(const std::string & output, const bool gzip)
+{
+  std::string stem = output;
+
+  if(gzip && ends_with(stem, ".gz")) {
+    stem.erase(stem.size() - 3);
+  }
+
+  const size_t slash = stem.find_last_of("/\\");
+  const size_t dot = stem.find_last_of('.');
+  const std::string suffix = gzip ? ".bin.gz" : ".bin";
+
+  if(dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+    const std::string path = stem.substr(0, dot) + suffix;
+
+    if(path != output) {
+      return path;
+    }
+  }
+
+  return stem + suffix;
+}
+
+static std::string file_name(const std::string & path)
+{
+  const size_t slash = path.find_last_of("/\\");
+
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Appends `size` bytes to the .bin file, padded so the next stream starts on
+// a four byte boundary, and advances `offset` past them.
+static void append_bytes(MemorySink & sink, const void * data, size_t size, size_t & offset)
+{
+  const size_t padding = (4 - size % 4) % 4;
+  const char zeros[4] = { 0, 0, 0, 0 };
+
+  sink.write(static_cast<const char *>(data), size);
+  sink.write(zeros, padding);
+
+  offset += size + padding;
+}
+
+// Meshes are handed to the worker threads in batches of this many per
+// thread, which bounds how much serialised output is held in memory at once.
+const size_t MESHES_PER_THREAD = 4;
+
+// Box and sphere of a mesh or submesh, keys in sorted order.
+static void write_bounds(JsonWriter & writer, const char * name, const Bounds & bounds)
+{
+  writer.key(name);
+  writer.begin_object();
+  writer.key("center");
+  writer.float_array(bounds.center, 1, 3, 3);
+  writer.key("max");
+  writer.float_array(bounds.max, 1, 3, 3);
+  writer.key("min");
+  writer.float_array(bounds.min, 1, 3, 3);
+  writer.key("radius");
+  writer.value(bounds.radius);
+  writer.end_object();
+}
+
+// Bounds sort before every stream name, so they open the mesh object.
+static void write_mesh_bounds(JsonWriter & writer, const VBOMesh * mesh)
+{
+  if(!mesh->animation_bounds.empty()) {
+    write_bounds(writer, "animation_bounds", mesh->animation_bounds);
+  }
+
+  if(!mesh->bounds.empty()) {
+    write_bounds(writer, "bounds", mesh->bounds);
+  }
+}
+
+// One entry per draw call: a range of the index array, in indices, and the
+// material slot it is drawn with. Slots of empty submeshes are skipped, so
+// "material" is the submesh's slot rather than its position in the array.
+// With `meshlets`, the entry also gives the submesh's range of meshlets.
+// "base_vertex" only appears when the submesh's indices are relative to it.
+static void write_submesh(JsonWriter & writer, const VBOMesh::SubMesh & submesh, int material, bool meshlets)
+{
+  if(submesh.triangle_count > 0) {
+    writer.begin_object();
+
+    if(submesh.base_vertex != 0) {
+      writer.key("base_vertex");
+      writer.value(submesh.base_vertex);
+    }
+
+    if(!submesh.bounds.empty()) {
+      write_bounds(writer, "bounds", submesh.bounds);
+    }
+
+    writer.key("index_count");
+    writer.value(submesh.triangle_count * 3);
+    writer.key("index_offset");
+    writer.value(submesh.index_offset);
+    writer.key("material");
+    writer.value(material);
+
+    if(meshlets) {
+      writer.key("meshlet_count");
+      writer.value(submesh.meshlet_count);
+      writer.key("meshlet_offset");
+      writer.value(submesh.meshlet_offset);
+    }
+
+    writer.end_object();
+  }
+}
+
+static void write_submeshes(JsonWriter & writer, const VBOMesh * mesh, bool meshlets)
+{
+  writer.key("submeshes");
+  writer.begin_array();
+
+  for(int s = 0; s < mesh->get_submesh_count(); ++s) {
+    write_submesh(writer, *mesh->get_submesh(s), s, meshlets);
+  }
+
+  writer.end_array();
+}
+
+static void write_submeshes(JsonWriter & writer, const VBOMesh::Lod & lod)
+{
+  writer.key("submeshes");
+  writer.begin_array();
+
+  for(size_t s = 0; s < lod.submeshes.size(); ++s) {
+    write_submesh(writer, lod.submeshes[s], static_cast<int>(s), false);
+  }
+
+  writer.end_array();
+}
+
+void Exporter::append_stream(BinaryMesh & encoded, const MeshStream & stream, size_t & offset)
+{
+  encoded.streams.push_back(encode_stream(encoded, stream, offset));
+}
+
+// Index streams go through the index codec, everything else through the
+// vertex codec, a whole element (padding included) being one vertex.
+Exporter::EncodedStream Exporter::encode_stream(BinaryMesh & encoded, const MeshStream & stream, size_t & offset)
+{
+  EncodedStream result(stream);
+  result.offset = offset;
+  result.byte_length = stream.byte_length();
+  result.view.data = NULL;
+
+  if(!options.compress || stream.byte_stride() > MAX_VERTEX_SIZE) {
+    append_bytes(encoded.data, stream.data, stream.byte_length(), offset);
+  } else {
+    std::vector<unsigned char> data;
+
+    if(stream.semantic == MeshStream::SEMANTIC_INDEX && stream.format == MeshStream::FORMAT_UINT32) {
+      encode_index_buffer(data, static_cast<const unsigned int *>(stream.data), stream.count);
+      result.compression = "index";
+    } else if(stream.semantic == MeshStream::SEMANTIC_INDEX && stream.format == MeshStream::FORMAT_UINT16) {
+      encode_index_buffer(data, static_cast<const unsigned short *>(stream.data), stream.count);
+      result.compression = "index";
+    } else {
+      encode_vertex_buffer(data, stream.data, stream.count, stream.byte_stride());
+      result.compression = "vertex";
+    }
+
+    result.byte_length = data.size();
+    append_bytes(encoded.data, &data[0], data.size(), offset);
+  }
+
+  return result;
+}
+
+// The non-empty vertex streams become one "vertex_buffer" stream of raw
+// interleaved vertices, which goes through the codecs like any other.
+void Exporter::append_interleaved(BinaryMesh & encoded, const std::vector<MeshStream> & streams, size_t & offset)
+{
+  InterleavedLayout layout;
+  layout_interleaved(streams, options.interleave_order, options.vertex_alignment, layout);
+
+  if(layout.attributes.empty()) {
+    return;
+  }
+
+  std::vector<unsigned char> vertices(layout.vertex_count * layout.vertex_size);
+  interleave(layout, &vertices[0]);
+
+  append_stream(encoded, MeshStream("vertex_buffer", MeshStream::SEMANTIC_INTERLEAVED, MeshStream::FORMAT_UINT8,
+                                    static_cast<int>(layout.vertex_size), static_cast<int>(layout.vertex_size),
+                                    layout.vertex_count, &vertices[0]), offset);
+
+  for(size_t i = 0; i < layout.attributes.size(); ++i) {
+    EncodedStream attribute(layout.attributes[i]);
+    attribute.view.stride = static_cast<int>(layout.vertex_size / attribute.view.value_size());
+    attribute.view.data = NULL;
+    attribute.offset = layout.offsets[i];
+    attribute.in_vertex_buffer = true;
+    encoded.streams.push_back(attribute);
+  }
+}
+
 Exporter::Exporter()
 {
 
 }
 
+Exporter::Exporter(const Options & options) : options(options)
+{
+
+}
+
 void Exporter::write(const std::string output, std::vector<VBOMesh *> * meshes)
 {
-  JsonBox::Array output_meshes;
+  if(options.format == Options::FORMAT_BINARY) {
+    write_binary(output, meshes);
+  } else if(options.format == Options::FORMAT_GLB) {
+    GlbExporter(options).write(output, meshes);
+  } else {
+    write_json(output, meshes);
+  }
+}
+
+int Exporter::thread_count() const
+{
+  return options.thread_count > 0 ? options.thread_count : hardware_thread_count();
+}
 
-  for(std::vector<VBOMesh *>::iterator m = meshes->begin(); m != meshes->end(); ++m) {
-    VBOMesh* mesh = *m;
+// Each mesh is formatted into its own buffer by a fragment writer and the
+// buffers are appended in order, so the file is the same whatever the number
+// of threads.
+void Exporter::write_json(const std::string output, std::vector<VBOMesh *> * meshes)
+{
+  OutputFile sink(output, options);
 
-    JsonBox::Object container;
+  if(!sink.is_open()) {
+    std::cerr << "Unable to open output file: " << output << std::endl;
+    return;
+  }
 
-    JsonBox::Array vertices;
-    JsonBox::Array normals;
-    JsonBox::Array uvs;
-    JsonBox::Array indices;
+  JsonWriter writer(&sink);
+  writer.begin_array();
+
+  const int threads = thread_count();
+  const size_t batch_size = MESHES_PER_THREAD * threads;
+
+  // A single thread gains nothing from the intermediate buffers.
+  if(threads == 1) {
+    for(std::vector<VBOMesh *>::iterator m = meshes->begin(); m != meshes->end(); ++m) {
+      write_mesh(writer, *m);
+    }
+  } else {
+    for(size_t first = 0; first < meshes->size(); first += batch_size) {
+      std::vector<MemorySink> fragments(std::min(batch_size, meshes->size() - first));
+      JsonBatch batch = { this, meshes, first, &writer, &fragments };
 
-    for(std::vector<float>::iterator vertex = mesh->vertices.begin(); vertex != mesh->vertices.end(); ++vertex) {
-      int index = std::distance(mesh->vertices.begin(), vertex);
-      --index;
+      parallel_for(fragments.size(), write_json_task, &batch, threads);
 
-      if(index % 4 != 2) { // ignore W
-        vertices.push_back(*vertex);
+      for(std::vector<MemorySink>::iterator fragment = fragments.begin(); fragment != fragments.end(); ++fragment) {
+        const std::vector<char> & data = fragment->get_data();
+        writer.append_values(&data[0], data.size(), 1);
       }
     }
+  }
+
+  writer.end_array();
+
+  if(!writer.flush() || !sink.close()) {
+    std::cerr << "Error writing output file: " << output << std::endl;
+  }
+}
+
+void Exporter::write_json_task(size_t index, void * context)
+{
+  JsonBatch * batch = static_cast<JsonBatch *>(context);
+  const size_t position = batch->first + index;
 
-    for(std::vector<float>::iterator normal = mesh->normals.begin(); normal != mesh->normals.end(); ++normal) {
-      normals.push_back(*normal);
+  JsonWriter writer(&(*batch->fragments)[index], *batch->parent, static_cast<int>(position));
+  batch->exporter->write_mesh(writer, (*batch->meshes)[position]);
+  writer.flush();
+}
+
+int Exporter::precision(MeshStream::Semantic semantic) const
+{
+  switch(semantic) {
+    case MeshStream::SEMANTIC_POSITION:
+      return options.position_precision;
+
+    case MeshStream::SEMANTIC_NORMAL:
+    case MeshStream::SEMANTIC_TANGENT:
+      return options.normal_precision;
+
+    case MeshStream::SEMANTIC_TEXCOORD:
+      return options.uv_precision;
+
+    default:
+      return -1;
+  }
+}
+
+// Keys are written in the order JsonBox::Object (a std::map) emitted them.
+void Exporter::write_mesh(JsonWriter & writer, const VBOMesh * mesh)
+{
+  std::vector<MeshStream> streams;
+  streams.push_back(mesh->get_index_stream());
+  mesh->get_vertex_streams(streams);
+  std::sort(streams.begin(), streams.end(), stream_name_less);
+
+  writer.begin_object();
+  write_mesh_bounds(writer, mesh);
+
+  bool lods_written = mesh->lods.empty();
+  bool ranges_written = false;
+
+  for(std::vector<MeshStream>::iterator stream = streams.begin(); stream != streams.end(); ++stream) {
+    if(!lods_written && std::string(stream->name) > "lods") {
+      write_lods(writer, mesh);
+      lods_written = true;
     }
 
-    for(std::vector<float>::iterator uv = mesh->uvs.begin(); uv != mesh->uvs.end(); ++uv) {
-      uvs.push_back(*uv);
+    if(!ranges_written && std::string(stream->name) > "submeshes") {
+      write_submeshes(writer, mesh, false);
+      ranges_written = true;
     }
 
-    for(std::vector<GLuint>::iterator index = mesh->indices.begin(); index != mesh->indices.end(); ++index) {
-      indices.push_back(int(*index));
+    writer.key(stream->name);
+    writer.stream_array(*stream, precision(stream->semantic));
+  }
+
+  if(!lods_written) {
+    write_lods(writer, mesh);
+  }
+
+  if(!ranges_written) {
+    write_submeshes(writer, mesh, false);
+  }
+
+  writer.end_object();
+}
+
+// Levels of detail share the mesh's vertices: each one has its error, its
+// own indices and the draw ranges within them.
+void Exporter::write_lods(JsonWriter & writer, const VBOMesh * mesh)
+{
+  writer.key("lods");
+  writer.begin_array();
+
+  for(std::vector<VBOMesh::Lod>::const_iterator lod = mesh->lods.begin(); lod != mesh->lods.end(); ++lod) {
+    writer.begin_object();
+    writer.key("error");
+    writer.value(lod->error);
+    writer.key("indices");
+    writer.stream_array(lod->get_index_stream(), -1);
+    write_submeshes(writer, *lod);
+    writer.end_object();
+  }
+
+  writer.end_array();
+}
+
+// The .bin file holds, for each mesh in turn, its streams (see
+// fbx_mesh_stream.h), each starting on a four byte boundary: the vertex
+// streams, or one interleaved vertex buffer with -i, then the indices, the
+// indices of each level of detail, the meshlet tables and the hierarchy.
+// With -q the vertex streams are quantized, and with -c every stream whose
+// elements fit the codecs is stored encoded. The descriptor gives each
+// stream an accessor with the offset, stride, component type and count to
+// read it back (little-endian on every platform we build for), plus the
+// dequantization parameters and encoded length where they apply.
+//
+// Meshes are encoded on the worker threads, then described and appended to
+// the .bin file in order once their sizes, and so their offsets, are known.
+void Exporter::write_binary(const std::string output, std::vector<VBOMesh *> * meshes)
+{
+  const std::string buffer_path = sidecar_path(output, options.gzip_level > 0);
+
+  OutputFile buffer_sink(buffer_path, options);
+  OutputFile sink(output, options);
+
+  if(!buffer_sink.is_open() || !sink.is_open()) {
+    std::cerr << "Unable to open output file: " << (sink.is_open() ? buffer_path : output) << std::endl;
+    return;
+  }
+
+  JsonWriter writer(&sink);
+  writer.begin_object();
+
+  writer.key("buffer");
+  writer.value(file_name(buffer_path));
+
+  writer.key("meshes");
+  writer.begin_array();
+
+  const int threads = thread_count();
+  const size_t batch_size = MESHES_PER_THREAD * threads;
+  size_t offset = 0;
+  bool written = true;
+
+  for(size_t first = 0; first < meshes->size(); first += batch_size) {
+    std::vector<BinaryMesh> encoded(std::min(batch_size, meshes->size() - first));
+    BinaryBatch batch = { this, meshes, first, &encoded };
+
+    parallel_for(encoded.size(), encode_binary_task, &batch, threads);
+
+    for(size_t i = 0; i < encoded.size(); ++i) {
+      const std::vector<char> & data = encoded[i].data.get_data();
+
+      describe_binary_mesh(writer, (*meshes)[first + i], encoded[i], offset);
+      written = (data.empty() || buffer_sink.write(&data[0], data.size())) && written;
+      offset += data.size();
+    }
+  }
+
+  writer.end_array();
+  writer.end_object();
+
+  if(!written || !buffer_sink.close() || !writer.flush() || !sink.close()) {
+    std::cerr << "Error writing output file: " << output << std::endl;
+  }
+}
+
+void Exporter::encode_binary_task(size_t index, void * context)
+{
+  BinaryBatch * batch = static_cast<BinaryBatch *>(context);
+
+  batch->exporter->encode_binary_mesh((*batch->meshes)[batch->first + index], (*batch->encoded)[index]);
+}
+
+void Exporter::encode_binary_mesh(const VBOMesh * mesh, BinaryMesh & encoded)
+{
+  std::vector<MeshStream> streams;
+  size_t offset = 0;
+
+  if(options.quantize_normal_bits > 0) {
+    quantize_mesh(*mesh, options.quantize_normal_bits, encoded.quantized);
+    encoded.quantized.get_vertex_streams(*mesh, streams);
+  } else {
+    mesh->get_vertex_streams(streams);
+  }
+
+  if(options.interleave) {
+    append_interleaved(encoded, streams, offset);
+    streams.clear();
+  }
+
+  streams.push_back(mesh->get_index_stream());
+
+  for(std::vector<MeshStream>::iterator stream = streams.begin(); stream != streams.end(); ++stream) {
+    append_stream(encoded, *stream, offset);
+  }
+
+  for(std::vector<VBOMesh::Lod>::const_iterator lod = mesh->lods.begin(); lod != mesh->lods.end(); ++lod) {
+    encoded.lod_indices.push_back(encode_stream(encoded, lod->get_index_stream(), offset));
+  }
+
+  if(!mesh->meshlets.empty()) {
+    std::vector<MeshStream> meshlet_streams;
+    mesh->get_meshlet_streams(meshlet_streams);
+
+    for(std::vector<MeshStream>::iterator stream = meshlet_streams.begin(); stream != meshlet_streams.end(); ++stream) {
+      encoded.meshlet_streams.push_back(encode_stream(encoded, *stream, offset));
+    }
+  }
+
+  if(!mesh->bvh_nodes.empty()) {
+    std::vector<MeshStream> bvh_streams;
+    mesh->get_bvh_streams(bvh_streams);
+
+    for(std::vector<MeshStream>::iterator stream = bvh_streams.begin(); stream != bvh_streams.end(); ++stream) {
+      encoded.bvh_streams.push_back(encode_stream(encoded, *stream, offset));
+    }
+  }
+
+  // Only the decoding parameters are needed from here on.
+  QuantizedMesh & quantized = encoded.quantized;
+  std::vector<int16_t>().swap(quantized.positions);
+  std::vector<int8_t>().swap(quantized.normals8);
+  std::vector<int16_t>().swap(quantized.normals16);
+  std::vector<uint16_t>().swap(quantized.uvs);
+}
+
+void Exporter::describe_binary_mesh(JsonWriter & writer, const VBOMesh * mesh, const BinaryMesh & encoded, size_t base)
+{
+  std::vector<EncodedStream> streams(encoded.streams);
+  std::sort(streams.begin(), streams.end(), EncodedStream::name_less);
+
+  writer.begin_object();
+  write_mesh_bounds(writer, mesh);
+
+  // "bvh" also sorts before every stream name.
+  if(!encoded.bvh_streams.empty()) {
+    describe_bvh(writer, encoded, base);
+  }
+
+  const bool has_meshlets = !mesh->meshlets.empty();
+  bool lods_written = mesh->lods.empty();
+  bool meshlets_written = !has_meshlets;
+  bool ranges_written = false;
+
+  for(std::vector<EncodedStream>::iterator stream = streams.begin(); stream != streams.end(); ++stream) {
+    if(!lods_written && std::string(stream->view.name) > "lods") {
+      describe_lods(writer, mesh, encoded, base);
+      lods_written = true;
+    }
+
+    if(!meshlets_written && std::string(stream->view.name) > "meshlets") {
+      describe_meshlets(writer, encoded, base);
+      meshlets_written = true;
+    }
+
+    if(!ranges_written && std::string(stream->view.name) > "submeshes") {
+      write_submeshes(writer, mesh, has_meshlets);
+      ranges_written = true;
+    }
+
+    begin_accessor(writer, *stream, base);
+
+    if(options.quantize_normal_bits > 0) {
+      describe_quantization(writer, stream->view, encoded.quantized);
     }
 
-    container["vertices"] = vertices;
-    container["normals"] = normals;
-    container["uvs"] = uvs;
-    container["indices"] = indices;
+    writer.end_object();
+  }
+
+  if(!lods_written) {
+    describe_lods(writer, mesh, encoded, base);
+  }
+
+  if(!meshlets_written) {
+    describe_meshlets(writer, encoded, base);
+  }
+
+  if(!ranges_written) {
+    write_submeshes(writer, mesh, has_meshlets);
+  }
+
+  writer.end_object();
+}
+
+void Exporter::describe_lods(JsonWriter & writer, const VBOMesh * mesh, const BinaryMesh & encoded, size_t base)
+{
+  writer.key("lods");
+  writer.begin_array();
+
+  for(size_t i = 0; i < mesh->lods.size(); ++i) {
+    writer.begin_object();
+    writer.key("error");
+    writer.value(mesh->lods[i].error);
+    begin_accessor(writer, encoded.lod_indices[i], base);
+    writer.end_object();
+    write_submeshes(writer, mesh->lods[i]);
+    writer.end_object();
+  }
+
+  writer.end_array();
+}
+
+// The meshlet tables are accessors of their own, grouped under "meshlets".
+void Exporter::describe_meshlets(JsonWriter & writer, const BinaryMesh & encoded, size_t base)
+{
+  writer.key("meshlets");
+  writer.begin_object();
+
+  for(std::vector<EncodedStream>::const_iterator stream = encoded.meshlet_streams.begin();
+      stream != encoded.meshlet_streams.end(); ++stream) {
+    begin_accessor(writer, *stream, base);
+    writer.end_object();
+  }
+
+  writer.end_object();
+}
+
+// The hierarchy's node array and triangle table, grouped under "bvh".
+void Exporter::describe_bvh(JsonWriter & writer, const BinaryMesh & encoded, size_t base)
+{
+  writer.key("bvh");
+  writer.begin_object();
+
+  for(std::vector<EncodedStream>::const_iterator stream = encoded.bvh_streams.begin();
+      stream != encoded.bvh_streams.end(); ++stream) {
+    begin_accessor(writer, *stream, base);
+    writer.end_object();
+  }
+
+  writer.end_object();
+}
+
+// Quantized accessors are flagged "normalized" and carry the largest error
+// measured while encoding them, see fbx_quantize.h for the decoding rules.
+void Exporter::describe_quantization(JsonWriter & writer, const MeshStream & stream, const QuantizedMesh & quantized)
+{
+  switch(stream.semantic) {
+    case MeshStream::SEMANTIC_POSITION:
+      writer.key("decode_offset");
+      writer.float_array(quantized.position_offset, 1, 3, 3);
+      writer.key("decode_scale");
+      writer.float_array(quantized.position_scale, 1, 3, 3);
+      writer.key("max_error");
+      writer.value(quantized.position_error);
+      writer.key("normalized");
+      writer.value(true);
+      break;
+
+    case MeshStream::SEMANTIC_NORMAL:
+      writer.key("encoding");
+      writer.value("octahedral");
+      writer.key("max_error");
+      writer.value(quantized.normal_error);
+      writer.key("normalized");
+      writer.value(true);
+      break;
+
+    case MeshStream::SEMANTIC_TEXCOORD:
+      if(stream.format == MeshStream::FORMAT_UINT16) {
+        writer.key("max_error");
+        writer.value(quantized.uv_error);
+        writer.key("normalized");
+        writer.value(true);
+      }
+
+      break;
+
+    default:
+      break;
+  }
+}
+
+// Keys a compressed stream adds are slotted in where JsonBox's ordering
+// would have put them.
+void Exporter::begin_accessor(JsonWriter & writer, const EncodedStream & stream, size_t base)
+{
+  const MeshStream & view = stream.view;
+
+  writer.key(view.name);
+  writer.begin_object();
+
+  if(stream.compression != NULL) {
+    writer.key("byte_length");
+    writer.value(stream.byte_length);
+  }
+
+  writer.key("byte_offset");
+  writer.value(stream.in_vertex_buffer ? stream.offset : base + stream.offset);
+  writer.key("byte_stride");
+  writer.value(view.byte_stride());
+  writer.key("component_type");
+  writer.value(view.type_name());
+  writer.key("components");
+  writer.value(view.components);
 
-    output_meshes.push_back(container);
+  if(stream.compression != NULL) {
+    writer.key("compression");
+    writer.value(stream.compression);
   }
 
-  JsonBox::Value v(output_meshes);
-  v.writeToFile(output);
+  writer.key("count");
+  writer.value(view.count);
 }
 
 Exporter::~Exporter()
@@ -23,10 +23,13 @@
 #ifndef FBX2JSON_FBXEXPORTER_H_
 #define FBX2JSON_FBXEXPORTER_H_
 
+#include <string>
 #include <vector>
-#include <iterator>
+#include "fbx_json_writer.h"
+#include "fbx_options.h"
+#include "fbx_quantize.h"
+#include "fbx_sink.h"
 #include "fbx_vbomesh.h"
-#include "JsonBox.h"
 
 namespace Fbx2Json
 {
@@ -35,10 +38,77 @@ class Exporter
 {
   public:
     Exporter();
+    Exporter(const Options & options);
     void write(const std::string output, std::vector<VBOMesh *> * meshes);
     ~Exporter();
 
   private:
+    // Where a stream landed in the .bin file. Compressed streams record the
+    // codec from fbx_codec.h that was used and their encoded size. The
+    // view's data is not kept past encoding. Attributes stored in a mesh's
+    // interleaved vertex buffer have their offset within the vertex instead.
+    struct EncodedStream {
+      EncodedStream(const MeshStream & view) :
+        view(view), offset(0), byte_length(0), compression(NULL), in_vertex_buffer(false) {}
+      static bool name_less(const EncodedStream & a, const EncodedStream & b) {
+        return stream_name_less(a.view, b.view);
+      }
+      MeshStream view;
+      size_t offset;
+      size_t byte_length;
+      const char * compression;
+      bool in_vertex_buffer;
+    };
+
+    // A mesh's share of the .bin file, encoded before it is described so
+    // that meshes can be processed in parallel. Stream offsets are relative
+    // to the start of `data`.
+    struct BinaryMesh {
+      MemorySink data;
+      std::vector<EncodedStream> streams;
+      std::vector<EncodedStream> lod_indices;
+      std::vector<EncodedStream> meshlet_streams;
+      std::vector<EncodedStream> bvh_streams;
+      QuantizedMesh quantized;
+    };
+
+    // The slice of meshes handed to parallel_for, starting at `first`.
+    struct JsonBatch {
+      Exporter * exporter;
+      std::vector<VBOMesh *> * meshes;
+      size_t first;
+      const JsonWriter * parent;
+      std::vector<MemorySink> * fragments;
+    };
+
+    struct BinaryBatch {
+      Exporter * exporter;
+      std::vector<VBOMesh *> * meshes;
+      size_t first;
+      std::vector<BinaryMesh> * encoded;
+    };
+
+    EncodedStream encode_stream(BinaryMesh & encoded, const MeshStream & stream, size_t & offset);
+    void append_stream(BinaryMesh & encoded, const MeshStream & stream, size_t & offset);
+    void append_interleaved(BinaryMesh & encoded, const std::vector<MeshStream> & streams, size_t & offset);
+
+    int thread_count() const;
+    void write_json(const std::string output, std::vector<VBOMesh *> * meshes);
+    static void write_json_task(size_t index, void * context);
+    int precision(MeshStream::Semantic semantic) const;
+    void write_mesh(JsonWriter & writer, const VBOMesh * mesh);
+    void write_lods(JsonWriter & writer, const VBOMesh * mesh);
+    void write_binary(const std::string output, std::vector<VBOMesh *> * meshes);
+    static void encode_binary_task(size_t index, void * context);
+    void encode_binary_mesh(const VBOMesh * mesh, BinaryMesh & encoded);
+    void describe_binary_mesh(JsonWriter & writer, const VBOMesh * mesh, const BinaryMesh & encoded, size_t base);
+    void describe_lods(JsonWriter & writer, const VBOMesh * mesh, const BinaryMesh & encoded, size_t base);
+    void describe_meshlets(JsonWriter & writer, const BinaryMesh & encoded, size_t base);
+    void describe_bvh(JsonWriter & writer, const BinaryMesh & encoded, size_t base);
+    void describe_quantization(JsonWriter & writer, const MeshStream & stream, const QuantizedMesh & quantized);
+    void begin_accessor(JsonWriter & writer, const EncodedStream & stream, size_t base);
+
+    Options options;
 };
 
 } // namespace Fbx2Json
@@ -0,0 +1,451 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include "fbx_float_format.h"
+
+namespace Fbx2Json
+{
+
+// Shortest round-trip formatting follows Ulf Adams' Ryu (PLDI 2018), float32
+// variant. The tables hold 5^i and 2^k / 5^i, normalised to 61 and 59
+// significant bits.
+const int FLOAT_MANTISSA_BITS = 23;
+const int FLOAT_EXPONENT_BITS = 8;
+const int FLOAT_BIAS = 127;
+const int FLOAT_POW5_INV_BITCOUNT = 59;
+const int FLOAT_POW5_BITCOUNT = 61;
+
+const uint64_t FLOAT_POW5_INV_SPLIT[31] = {
+  576460752303423489ull, 461168601842738791ull, 368934881474191033ull,
+  295147905179352826ull, 472236648286964522ull, 377789318629571618ull,
+  302231454903657294ull, 483570327845851670ull, 386856262276681336ull,
+  309485009821345069ull, 495176015714152110ull, 396140812571321688ull,
+  316912650057057351ull, 507060240091291761ull, 405648192073033409ull,
+  324518553658426727ull, 519229685853482763ull, 415383748682786211ull,
+  332306998946228969ull, 531691198313966350ull, 425352958651173080ull,
+  340282366920938464ull, 544451787073501542ull, 435561429658801234ull,
+  348449143727040987ull, 557518629963265579ull, 446014903970612463ull,
+  356811923176489971ull, 570899077082383953ull, 456719261665907162ull,
+  365375409332725730ull
+};
+
+const uint64_t FLOAT_POW5_SPLIT[48] = {
+  1152921504606846976ull, 1441151880758558720ull, 1801439850948198400ull,
+  2251799813685248000ull, 1407374883553280000ull, 1759218604441600000ull,
+  2199023255552000000ull, 1374389534720000000ull, 1717986918400000000ull,
+  2147483648000000000ull, 1342177280000000000ull, 1677721600000000000ull,
+  2097152000000000000ull, 1310720000000000000ull, 1638400000000000000ull,
+  2048000000000000000ull, 1280000000000000000ull, 1600000000000000000ull,
+  2000000000000000000ull, 1250000000000000000ull, 1562500000000000000ull,
+  1953125000000000000ull, 1220703125000000000ull, 1525878906250000000ull,
+  1907348632812500000ull, 1192092895507812500ull, 1490116119384765625ull,
+  1862645149230957031ull, 1164153218269348144ull, 1455191522836685180ull,
+  1818989403545856475ull, 2273736754432320594ull, 1421085471520200371ull,
+  1776356839400250464ull, 2220446049250313080ull, 1387778780781445675ull,
+  1734723475976807094ull, 2168404344971008868ull, 1355252715606880542ull,
+  1694065894508600678ull, 2117582368135750847ull, 1323488980084844279ull,
+  1654361225106055349ull, 2067951531382569187ull, 1292469707114105741ull,
+  1615587133892632177ull, 2019483917365790221ull, 1262177448353618888ull
+};
+
+static inline int pow5bits(const int e)
+{
+  return static_cast<int>((static_cast<uint32_t>(e) * 1217359) >> 19) + 1;
+}
+
+static inline int log10_pow2(const int e)
+{
+  return static_cast<int>((static_cast<uint32_t>(e) * 78913) >> 18);
+}
+
+static inline int log10_pow5(const int e)
+{
+  return static_cast<int>((static_cast<uint32_t>(e) * 732923) >> 20);
+}
+
+static inline int pow5_factor(uint32_t value)
+{
+  int count = 0;
+
+  while(value % 5 == 0) {
+    value /= 5;
+    ++count;
+  }
+
+  return count;
+}
+
+static inline bool multiple_of_pow5(const uint32_t value, const int p)
+{
+  return pow5_factor(value) >= p;
+}
+
+static inline bool multiple_of_pow2(const uint32_t value, const int p)
+{
+  return (value & ((1u << p) - 1)) == 0;
+}
+
+static inline uint32_t mul_shift(const uint32_t m, const uint64_t factor, const int shift)
+{
+  const uint64_t bits0 = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor);
+  const uint64_t bits1 = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor >> 32);
+  const uint64_t sum = (bits0 >> 32) + bits1;
+  return static_cast<uint32_t>(sum >> (shift - 32));
+}
+
+// Finds the shortest decimal `digits` * 10^`exponent` inside the rounding
+// interval of a finite, non-zero float.
+static void shortest_decimal(const uint32_t ieee_mantissa, const uint32_t ieee_exponent, uint32_t & digits, int & exponent)
+{
+  int e2;
+  uint32_t m2;
+
+  if(ieee_exponent == 0) {
+    e2 = 1 - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = static_cast<int>(ieee_exponent) - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+    m2 = (1u << FLOAT_MANTISSA_BITS) | ieee_mantissa;
+  }
+
+  const bool accept_bounds = (m2 & 1) == 0;
+
+  // The interval of decimal values that round to this float, scaled by 4.
+  const uint32_t mv = 4 * m2;
+  const uint32_t mp = 4 * m2 + 2;
+  const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+  const uint32_t mm = 4 * m2 - 1 - mm_shift;
+
+  uint32_t vr, vp, vm;
+  int e10;
+  bool vm_is_trailing_zeros = false;
+  bool vr_is_trailing_zeros = false;
+  uint8_t last_removed_digit = 0;
+
+  if(e2 >= 0) {
+    const int q = log10_pow2(e2);
+    e10 = q;
+    const int k = FLOAT_POW5_INV_BITCOUNT + pow5bits(q) - 1;
+    const int i = -e2 + q + k;
+    vr = mul_shift(mv, FLOAT_POW5_INV_SPLIT[q], i);
+    vp = mul_shift(mp, FLOAT_POW5_INV_SPLIT[q], i);
+    vm = mul_shift(mm, FLOAT_POW5_INV_SPLIT[q], i);
+
+    if(q != 0 && (vp - 1) / 10 <= vm / 10) {
+      const int l = FLOAT_POW5_INV_BITCOUNT + pow5bits(q - 1) - 1;
+      last_removed_digit = static_cast<uint8_t>(mul_shift(mv, FLOAT_POW5_INV_SPLIT[q - 1], -e2 + q - 1 + l) % 10);
+    }
+
+    if(q <= 9) {
+      if(mv % 5 == 0) {
+        vr_is_trailing_zeros = multiple_of_pow5(mv, q);
+      } else if(accept_bounds) {
+        vm_is_trailing_zeros = multiple_of_pow5(mm, q);
+      } else {
+        vp -= multiple_of_pow5(mp, q);
+      }
+    }
+  } else {
+    const int q = log10_pow5(-e2);
+    e10 = q + e2;
+    const int i = -e2 - q;
+    const int k = pow5bits(i) - FLOAT_POW5_BITCOUNT;
+    int j = q - k;
+    vr = mul_shift(mv, FLOAT_POW5_SPLIT[i], j);
+    vp = mul_shift(mp, FLOAT_POW5_SPLIT[i], j);
+    vm = mul_shift(mm, FLOAT_POW5_SPLIT[i], j);
+
+    if(q != 0 && (vp - 1) / 10 <= vm / 10) {
+      j = q - 1 - (pow5bits(i + 1) - FLOAT_POW5_BITCOUNT);
+      last_removed_digit = static_cast<uint8_t>(mul_shift(mv, FLOAT_POW5_SPLIT[i + 1], j) % 10);
+    }
+
+    if(q <= 1) {
+      vr_is_trailing_zeros = true;
+
+      if(accept_bounds) {
+        vm_is_trailing_zeros = mm_shift == 1;
+      } else {
+        --vp;
+      }
+    } else if(q < 31) {
+      vr_is_trailing_zeros = multiple_of_pow2(mv, q - 1);
+    }
+  }
+
+  // Remove digits while the interval still contains a shorter candidate.
+  int removed = 0;
+  uint32_t output;
+
+  if(vm_is_trailing_zeros || vr_is_trailing_zeros) {
+    while(vp / 10 > vm / 10) {
+      vm_is_trailing_zeros &= vm % 10 == 0;
+      vr_is_trailing_zeros &= last_removed_digit == 0;
+      last_removed_digit = static_cast<uint8_t>(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+
+    if(vm_is_trailing_zeros) {
+      while(vm % 10 == 0) {
+        vr_is_trailing_zeros &= last_removed_digit == 0;
+        last_removed_digit = static_cast<uint8_t>(vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        ++removed;
+      }
+    }
+
+    if(vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+      // Round even if the exact number is .....50..0.
+      last_removed_digit = 4;
+    }
+
+    output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) || last_removed_digit >= 5);
+  } else {
+    while(vp / 10 > vm / 10) {
+      last_removed_digit = static_cast<uint8_t>(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+
+    output = vr + (vr == vm || last_removed_digit >= 5);
+  }
+
+  digits = output;
+  exponent = e10 + removed;
+}
+
+static inline int decimal_length(const uint32_t v)
+{
+  int length = 1;
+
+  for(uint32_t limit = 10; length < 10 && v >= limit; limit *= 10) {
+    ++length;
+  }
+
+  return length;
+}
+
+static inline int write_uint(uint32_t value, char * buffer)
+{
+  const int length = decimal_length(value);
+
+  for(int i = length - 1; i >= 0; --i) {
+    buffer[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+
+  return length;
+}
+
+// Zero, infinities and NaN. The latter two have no JSON representation.
+static int write_special(const uint32_t bits, char * buffer)
+{
+  if((bits & 0x7fffffffu) != 0) {
+    memcpy(buffer, "null", 4);
+    return 4;
+  }
+
+  int length = 0;
+
+  if(bits >> 31) {
+    buffer[length++] = '-';
+  }
+
+  buffer[length++] = '0';
+
+  return length;
+}
+
+int format_float_shortest(float value, char * buffer)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  const uint32_t ieee_mantissa = bits & ((1u << FLOAT_MANTISSA_BITS) - 1);
+  const uint32_t ieee_exponent = (bits >> FLOAT_MANTISSA_BITS) & ((1u << FLOAT_EXPONENT_BITS) - 1);
+
+  if(ieee_exponent == ((1u << FLOAT_EXPONENT_BITS) - 1) || (ieee_exponent == 0 && ieee_mantissa == 0)) {
+    return write_special(bits, buffer);
+  }
+
+  uint32_t digits;
+  int exponent;
+  shortest_decimal(ieee_mantissa, ieee_exponent, digits, exponent);
+
+  const int digit_count = decimal_length(digits);
+  const int point = digit_count + exponent;
+  const int scientific_exponent = point - 1;
+
+  // Pick plain notation unless exponent notation is strictly shorter.
+  int plain_length;
+
+  if(point <= 0) {
+    plain_length = 2 - point + digit_count;
+  } else if(point >= digit_count) {
+    plain_length = point;
+  } else {
+    plain_length = digit_count + 1;
+  }
+
+  const int scientific_length = digit_count + (digit_count > 1) + 1 + (scientific_exponent < 0) +
+                                decimal_length(static_cast<uint32_t>(scientific_exponent < 0 ? -scientific_exponent : scientific_exponent));
+
+  int length = 0;
+
+  if(bits >> 31) {
+    buffer[length++] = '-';
+  }
+
+  char text[10];
+  write_uint(digits, text);
+
+  if(plain_length <= scientific_length) {
+    if(point <= 0) {
+      buffer[length++] = '0';
+      buffer[length++] = '.';
+
+      for(int i = point; i < 0; ++i) {
+        buffer[length++] = '0';
+      }
+
+      memcpy(buffer + length, text, digit_count);
+      length += digit_count;
+    } else if(point >= digit_count) {
+      memcpy(buffer + length, text, digit_count);
+      length += digit_count;
+
+      for(int i = digit_count; i < point; ++i) {
+        buffer[length++] = '0';
+      }
+    } else {
+      memcpy(buffer + length, text, point);
+      length += point;
+      buffer[length++] = '.';
+      memcpy(buffer + length, text + point, digit_count - point);
+      length += digit_count - point;
+    }
+  } else {
+    buffer[length++] = text[0];
+
+    if(digit_count > 1) {
+      buffer[length++] = '.';
+      memcpy(buffer + length, text + 1, digit_count - 1);
+      length += digit_count - 1;
+    }
+
+    buffer[length++] = 'e';
+
+    if(scientific_exponent < 0) {
+      buffer[length++] = '-';
+      length += write_uint(static_cast<uint32_t>(-scientific_exponent), buffer + length);
+    } else {
+      length += write_uint(static_cast<uint32_t>(scientific_exponent), buffer + length);
+    }
+  }
+
+  return length;
+}
+
+const int MAX_FIXED_DECIMALS = 9;
+const double POWERS_OF_TEN[MAX_FIXED_DECIMALS + 1] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+int format_float_fixed(float value, int decimals, char * buffer)
+{
+  if(decimals < 0 || decimals > MAX_FIXED_DECIMALS) {
+    return format_float_shortest(value, buffer);
+  }
+
+  const double scaled = std::floor(std::fabs(static_cast<double>(value)) * POWERS_OF_TEN[decimals] + 0.5);
+
+  // Beyond 32 bits of integer part the float has no fractional digits left.
+  if(!(scaled < 4294967296.0)) {
+    return format_float_shortest(value, buffer);
+  }
+
+  uint32_t units = static_cast<uint32_t>(scaled);
+  int length = 0;
+
+  if(units == 0) {
+    buffer[length++] = '0';
+    return length;
+  }
+
+  // Drop trailing zeros of the fraction.
+  while(decimals > 0 && units % 10 == 0) {
+    units /= 10;
+    --decimals;
+  }
+
+  if(value < 0) {
+    buffer[length++] = '-';
+  }
+
+  char text[10];
+  const int digit_count = write_uint(units, text);
+
+  if(decimals == 0) {
+    memcpy(buffer + length, text, digit_count);
+    length += digit_count;
+  } else if(digit_count <= decimals) {
+    buffer[length++] = '0';
+    buffer[length++] = '.';
+
+    for(int i = digit_count; i < decimals; ++i) {
+      buffer[length++] = '0';
+    }
+
+    memcpy(buffer + length, text, digit_count);
+    length += digit_count;
+  } else {
+    memcpy(buffer + length, text, digit_count - decimals);
+    length += digit_count - decimals;
+    buffer[length++] = '.';
+    memcpy(buffer + length, text + digit_count - decimals, decimals);
+    length += decimals;
+  }
+
+  // The round-trip representation wins when it is shorter (e.g. 0.1f with
+  // nine decimals), it is never less accurate than the fixed one.
+  char shortest[FLOAT_FORMAT_BUFFER_SIZE];
+  const int shortest_length = format_float_shortest(value, shortest);
+
+  if(shortest_length < length) {
+    memcpy(buffer, shortest, shortest_length);
+    return shortest_length;
+  }
+
+  return length;
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXFLOATFORMAT_H_
+#define FBX2JSON_FBXFLOATFORMAT_H_
+
+namespace Fbx2Json
+{
+
+// Large enough for any output of the functions below.
+const int FLOAT_FORMAT_BUFFER_SIZE = 32;
+
+// Writes the shortest decimal text that reads back as exactly `value` when
+// parsed as a float32 (Ryu algorithm), choosing plain or exponent notation,
+// whichever is shorter. Returns the number of characters written.
+int format_float_shortest(float value, char * buffer);
+
+// Writes `value` rounded to `decimals` fractional digits with trailing zeros
+// removed. Falls back to the shortest representation when that is shorter
+// or the value is too large for fixed notation.
+int format_float_fixed(float value, int decimals, char * buffer);
+
+} // namespace Fbx2Json
+
+#endif
@@ -0,0 +1,580 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdint.h>
+#include "fbx_glb_exporter.h"
+#include "fbx_output_file.h"
+
+namespace Fbx2Json
+{
+
+const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+const uint32_t GLB_VERSION = 2;
+const uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+const uint32_t GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+const size_t GLB_HEADER_SIZE = 12;
+const size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+const int GL_ARRAY_BUFFER_TARGET = 34962;
+const int GL_ELEMENT_ARRAY_BUFFER_TARGET = 34963;
+const int GL_TRIANGLES_MODE = 4;
+
+// The scene is baked in centimetres, glTF is in metres.
+const float CENTIMETRES_TO_METRES = 0.01f;
+
+const size_t UV_FLIP_BATCH = 4096;
+
+static bool write_uint32(Sink & sink, const uint32_t value)
+{
+  const char bytes[4] = {
+    static_cast<char>(value & 0xff),
+    static_cast<char>((value >> 8) & 0xff),
+    static_cast<char>((value >> 16) & 0xff),
+    static_cast<char>((value >> 24) & 0xff)
+  };
+
+  return sink.write(bytes, sizeof(bytes));
+}
+
+template <typename T>
+static bool write_vector(Sink & sink, const std::vector<T> & data)
+{
+  if(data.empty()) {
+    return true;
+  }
+
+  return sink.write(reinterpret_cast<const char *>(&data[0]), data.size() * sizeof(T));
+}
+
+// glTF puts the UV origin at the top left, FBX at the bottom left, so the
+// second component of float texture coordinates is flipped on the way out.
+// That reverses the bitangents too, hence the tangents' handedness.
+static bool write_stream(Sink & sink, const MeshStream & stream)
+{
+  int flipped = -1;
+
+  if(stream.format == MeshStream::FORMAT_FLOAT32 && stream.semantic == MeshStream::SEMANTIC_TEXCOORD) {
+    flipped = 1;
+  } else if(stream.format == MeshStream::FORMAT_FLOAT32 && stream.semantic == MeshStream::SEMANTIC_TANGENT) {
+    flipped = 3;
+  }
+
+  if(flipped < 0) {
+    return stream.empty() || sink.write(static_cast<const char *>(stream.data), stream.byte_length());
+  }
+
+  const float * values = static_cast<const float *>(stream.data);
+  const size_t value_count = stream.count * stream.stride;
+  float batch[UV_FLIP_BATCH * 2];
+
+  for(size_t start = 0; start < value_count; start += UV_FLIP_BATCH * 2) {
+    const size_t end = std::min(value_count, start + UV_FLIP_BATCH * 2);
+
+    for(size_t i = start; i < end; ++i) {
+      if(static_cast<int>(i % stream.stride) != flipped) {
+        batch[i - start] = values[i];
+      } else if(stream.semantic == MeshStream::SEMANTIC_TEXCOORD) {
+        batch[i - start] = 1.f - values[i];
+      } else {
+        batch[i - start] = -values[i];
+      }
+    }
+
+    if(!sink.write(reinterpret_cast<const char *>(batch), (end - start) * sizeof(float))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static size_t padded_length(const size_t length)
+{
+  return (length + 3) & ~static_cast<size_t>(3);
+}
+
+static int gl_component_type(const MeshStream::Format format)
+{
+  switch(format) {
+    case MeshStream::FORMAT_INT8:
+      return 5120;
+
+    case MeshStream::FORMAT_UINT8:
+      return 5121;
+
+    case MeshStream::FORMAT_INT16:
+      return 5122;
+
+    case MeshStream::FORMAT_UINT16:
+      return 5123;
+
+    case MeshStream::FORMAT_UINT32:
+      return 5125;
+
+    default:
+      return 5126;
+  }
+}
+
+static const char * gltf_type(const int components)
+{
+  switch(components) {
+    case 1:
+      return "SCALAR";
+
+    case 2:
+      return "VEC2";
+
+    case 3:
+      return "VEC3";
+
+    default:
+      return "VEC4";
+  }
+}
+
+static std::string gltf_attribute(const MeshStream & stream)
+{
+  std::ostringstream name;
+
+  switch(stream.semantic) {
+    case MeshStream::SEMANTIC_NORMAL:
+      return "NORMAL";
+
+    case MeshStream::SEMANTIC_TANGENT:
+      return "TANGENT";
+
+    case MeshStream::SEMANTIC_TEXCOORD:
+      name << "TEXCOORD_" << stream.set;
+      return name.str();
+
+    case MeshStream::SEMANTIC_COLOR:
+      name << "COLOR_" << stream.set;
+      return name.str();
+
+    default:
+      return "POSITION";
+  }
+}
+
+static void write_float3(JsonWriter & writer, const float * values)
+{
+  writer.begin_array();
+  writer.value(values[0]);
+  writer.value(values[1]);
+  writer.value(values[2]);
+  writer.end_array();
+}
+
+GlbExporter::MeshLayout::MeshLayout() : mesh(NULL), indices_offset(0), first_buffer_view(0), first_accessor(0)
+{
+  for(int i = 0; i < 3; ++i) {
+    min[i] = 0;
+    max[i] = 0;
+  }
+}
+
+GlbExporter::GlbExporter()
+{
+
+}
+
+GlbExporter::GlbExporter(const Options & options) : options(options)
+{
+
+}
+
+void GlbExporter::write(const std::string output, std::vector<VBOMesh *> * meshes)
+{
+  std::vector<MeshLayout> layouts;
+  const size_t buffer_length = layout_meshes(meshes, layouts);
+
+  MemorySink document;
+  JsonWriter writer(&document, false);
+  write_document(writer, layouts, buffer_length);
+  writer.flush();
+
+  const size_t json_length = padded_length(document.get_data().size());
+  const size_t total_length = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE + json_length +
+                              (buffer_length > 0 ? GLB_CHUNK_HEADER_SIZE + buffer_length : 0);
+
+  if(total_length > 0xffffffffu) {
+    std::cerr << "Error: " << output << " would exceed the 4GB limit of a GLB file" << std::endl;
+    return;
+  }
+
+  OutputFile sink(output, options);
+
+  if(!sink.is_open()) {
+    std::cerr << "Unable to open output file: " << output << std::endl;
+    return;
+  }
+
+  bool written = write_uint32(sink, GLB_MAGIC) &&
+                 write_uint32(sink, GLB_VERSION) &&
+                 write_uint32(sink, static_cast<uint32_t>(total_length));
+
+  // The JSON chunk is padded with spaces to keep the BIN chunk aligned.
+  written = written &&
+            write_uint32(sink, static_cast<uint32_t>(json_length)) &&
+            write_uint32(sink, GLB_CHUNK_JSON) &&
+            write_vector(sink, document.get_data()) &&
+            sink.write("   ", json_length - document.get_data().size());
+
+  if(buffer_length > 0) {
+    written = written &&
+              write_uint32(sink, static_cast<uint32_t>(buffer_length)) &&
+              write_uint32(sink, GLB_CHUNK_BIN) &&
+              write_binary_chunk(sink, layouts);
+  }
+
+  if(!written || !sink.close()) {
+    std::cerr << "Error writing output file: " << output << std::endl;
+  }
+}
+
+// Meshes without geometry cannot be expressed in glTF and are skipped. Vertex
+// streams are a multiple of four bytes long; 16-bit indices are padded so the
+// next mesh's views stay aligned.
+size_t GlbExporter::layout_meshes(std::vector<VBOMesh *> * meshes, std::vector<MeshLayout> & layouts)
+{
+  size_t offset = 0;
+  int buffer_view = 0;
+  int accessor = 0;
+
+  for(std::vector<VBOMesh *>::iterator m = meshes->begin(); m != meshes->end(); ++m) {
+    const VBOMesh * mesh = *m;
+
+    if(mesh->vertices.empty() || mesh->get_index_stream().empty()) {
+      continue;
+    }
+
+    MeshLayout layout;
+    layout.mesh = mesh;
+    layout.first_buffer_view = buffer_view;
+    layout.first_accessor = accessor;
+
+    std::vector<MeshStream> streams;
+    mesh->get_vertex_streams(streams);
+
+    for(std::vector<MeshStream>::iterator stream = streams.begin(); stream != streams.end(); ++stream) {
+      if(stream->empty()) {
+        continue;
+      }
+
+      layout.attributes.push_back(*stream);
+      layout.attribute_offsets.push_back(offset);
+      offset += stream->byte_length();
+
+      // POSITION accessors must carry their bounds, which baking has already
+      // computed for meshes that went through initialize.
+      if(stream->semantic == MeshStream::SEMANTIC_POSITION && !mesh->bounds.empty()) {
+        for(int j = 0; j < 3; ++j) {
+          layout.min[j] = mesh->bounds.min[j];
+          layout.max[j] = mesh->bounds.max[j];
+        }
+      }
+      else if(stream->semantic == MeshStream::SEMANTIC_POSITION) {
+        const float * values = static_cast<const float *>(stream->data);
+
+        for(int j = 0; j < 3; ++j) {
+          layout.min[j] = layout.max[j] = values[j];
+        }
+
+        for(size_t i = 0; i < stream->count; ++i) {
+          for(int j = 0; j < 3; ++j) {
+            layout.min[j] = std::min(layout.min[j], values[i * stream->stride + j]);
+            layout.max[j] = std::max(layout.max[j], values[i * stream->stride + j]);
+          }
+        }
+      }
+    }
+
+    layout.indices_offset = offset;
+    offset += padded_length(mesh->get_index_stream().byte_length());
+
+    buffer_view += static_cast<int>(layout.attributes.size()) + 1;
+    accessor += static_cast<int>(layout.attributes.size());
+
+    for(int i = 0; i < mesh->get_submesh_count(); ++i) {
+      accessor += mesh->get_submesh(i)->triangle_count > 0;
+    }
+
+    layouts.push_back(layout);
+  }
+
+  return offset;
+}
+
+// Every mesh gets its own node under a root node that converts the baked
+// world-space centimetres to metres.
+void GlbExporter::write_document(JsonWriter & writer, const std::vector<MeshLayout> & layouts, size_t buffer_length)
+{
+  writer.begin_object();
+
+  writer.key("asset");
+  writer.begin_object();
+  writer.key("generator");
+  writer.value(std::string("fbx2json"));
+  writer.key("version");
+  writer.value(std::string("2.0"));
+  writer.end_object();
+
+  writer.key("scene");
+  writer.value(0);
+
+  writer.key("scenes");
+  writer.begin_array();
+  writer.begin_object();
+  writer.key("nodes");
+  writer.begin_array();
+  writer.value(0);
+  writer.end_array();
+  writer.end_object();
+  writer.end_array();
+
+  writer.key("nodes");
+  writer.begin_array();
+  writer.begin_object();
+  writer.key("name");
+  writer.value(std::string("RootNode"));
+  writer.key("scale");
+  const float scale[3] = { CENTIMETRES_TO_METRES, CENTIMETRES_TO_METRES, CENTIMETRES_TO_METRES };
+  write_float3(writer, scale);
+
+  if(!layouts.empty()) {
+    writer.key("children");
+    writer.begin_array();
+
+    for(size_t i = 0; i < layouts.size(); ++i) {
+      writer.value(static_cast<unsigned int>(i + 1));
+    }
+
+    writer.end_array();
+  }
+
+  writer.end_object();
+
+  for(size_t i = 0; i < layouts.size(); ++i) {
+    writer.begin_object();
+    writer.key("mesh");
+    writer.value(static_cast<unsigned int>(i));
+
+    if(!layouts[i].mesh->name.empty()) {
+      writer.key("name");
+      writer.value(layouts[i].mesh->name);
+    }
+
+    writer.end_object();
+  }
+
+  writer.end_array();
+
+  if(!layouts.empty()) {
+    write_meshes(writer, layouts);
+    write_accessors(writer, layouts);
+    write_buffer_views(writer, layouts);
+
+    writer.key("buffers");
+    writer.begin_array();
+    writer.begin_object();
+    writer.key("byteLength");
+    writer.value(buffer_length);
+    writer.end_object();
+    writer.end_array();
+  }
+
+  writer.end_object();
+}
+
+static void write_buffer_view(JsonWriter & writer, size_t offset, size_t length, int stride, int target)
+{
+  writer.begin_object();
+  writer.key("buffer");
+  writer.value(0);
+  writer.key("byteOffset");
+  writer.value(offset);
+  writer.key("byteLength");
+  writer.value(length);
+
+  if(stride > 0) {
+    writer.key("byteStride");
+    writer.value(stride);
+  }
+
+  writer.key("target");
+  writer.value(target);
+  writer.end_object();
+}
+
+void GlbExporter::write_buffer_views(JsonWriter & writer, const std::vector<MeshLayout> & layouts)
+{
+  writer.key("bufferViews");
+  writer.begin_array();
+
+  for(std::vector<MeshLayout>::const_iterator l = layouts.begin(); l != layouts.end(); ++l) {
+    for(size_t i = 0; i < l->attributes.size(); ++i) {
+      const MeshStream & attribute = l->attributes[i];
+      write_buffer_view(writer, l->attribute_offsets[i], attribute.byte_length(), static_cast<int>(attribute.byte_stride()),
+                        GL_ARRAY_BUFFER_TARGET);
+    }
+
+    write_buffer_view(writer, l->indices_offset, l->mesh->get_index_stream().byte_length(), 0, GL_ELEMENT_ARRAY_BUFFER_TARGET);
+  }
+
+  writer.end_array();
+}
+
+static void write_accessor(JsonWriter & writer, int buffer_view, size_t offset, int component_type, size_t count, const char * type)
+{
+  writer.begin_object();
+  writer.key("bufferView");
+  writer.value(buffer_view);
+
+  if(offset > 0) {
+    writer.key("byteOffset");
+    writer.value(offset);
+  }
+
+  writer.key("componentType");
+  writer.value(component_type);
+  writer.key("count");
+  writer.value(count);
+  writer.key("type");
+  writer.value(std::string(type));
+}
+
+void GlbExporter::write_accessors(JsonWriter & writer, const std::vector<MeshLayout> & layouts)
+{
+  writer.key("accessors");
+  writer.begin_array();
+
+  for(std::vector<MeshLayout>::const_iterator l = layouts.begin(); l != layouts.end(); ++l) {
+    int buffer_view = l->first_buffer_view;
+
+    for(std::vector<MeshStream>::const_iterator attribute = l->attributes.begin(); attribute != l->attributes.end(); ++attribute) {
+      write_accessor(writer, buffer_view++, 0, gl_component_type(attribute->format), attribute->count, gltf_type(attribute->components));
+
+      if(attribute->semantic == MeshStream::SEMANTIC_POSITION) {
+        writer.key("min");
+        write_float3(writer, l->min);
+        writer.key("max");
+        write_float3(writer, l->max);
+      }
+
+      writer.end_object();
+    }
+
+    const MeshStream indices = l->mesh->get_index_stream();
+
+    for(int i = 0; i < l->mesh->get_submesh_count(); ++i) {
+      const VBOMesh::SubMesh * submesh = l->mesh->get_submesh(i);
+
+      if(submesh->triangle_count > 0) {
+        write_accessor(writer, buffer_view, submesh->index_offset * indices.byte_stride(), gl_component_type(indices.format),
+                       static_cast<size_t>(submesh->triangle_count) * 3, "SCALAR");
+        writer.end_object();
+      }
+    }
+  }
+
+  writer.end_array();
+}
+
+// One primitive per material submesh, all sharing the mesh's vertex accessors.
+void GlbExporter::write_meshes(JsonWriter & writer, const std::vector<MeshLayout> & layouts)
+{
+  writer.key("meshes");
+  writer.begin_array();
+
+  for(std::vector<MeshLayout>::const_iterator l = layouts.begin(); l != layouts.end(); ++l) {
+    const VBOMesh * mesh = l->mesh;
+    int accessor = l->first_accessor + static_cast<int>(l->attributes.size());
+
+    writer.begin_object();
+
+    if(!mesh->name.empty()) {
+      writer.key("name");
+      writer.value(mesh->name);
+    }
+
+    writer.key("primitives");
+    writer.begin_array();
+
+    for(int i = 0; i < mesh->get_submesh_count(); ++i) {
+      if(mesh->get_submesh(i)->triangle_count == 0) {
+        continue;
+      }
+
+      writer.begin_object();
+      writer.key("attributes");
+      writer.begin_object();
+
+      for(size_t j = 0; j < l->attributes.size(); ++j) {
+        writer.key(gltf_attribute(l->attributes[j]).c_str());
+        writer.value(l->first_accessor + static_cast<int>(j));
+      }
+
+      writer.end_object();
+      writer.key("indices");
+      writer.value(accessor++);
+      writer.key("mode");
+      writer.value(GL_TRIANGLES_MODE);
+      writer.end_object();
+    }
+
+    writer.end_array();
+    writer.end_object();
+  }
+
+  writer.end_array();
+}
+
+bool GlbExporter::write_binary_chunk(Sink & sink, const std::vector<MeshLayout> & layouts)
+{
+  for(std::vector<MeshLayout>::const_iterator l = layouts.begin(); l != layouts.end(); ++l) {
+    for(std::vector<MeshStream>::const_iterator attribute = l->attributes.begin(); attribute != l->attributes.end(); ++attribute) {
+      if(!write_stream(sink, *attribute)) {
+        return false;
+      }
+    }
+
+    const MeshStream indices = l->mesh->get_index_stream();
+    const char zeros[4] = { 0, 0, 0, 0 };
+
+    if(!write_stream(sink, indices) || !sink.write(zeros, padded_length(indices.byte_length()) - indices.byte_length())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+GlbExporter::~GlbExporter()
+{
+
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXGLBEXPORTER_H_
+#define FBX2JSON_FBXGLBEXPORTER_H_
+
+#include <string>
+#include <vector>
+#include "fbx_json_writer.h"
+#include "fbx_options.h"
+#include "fbx_sink.h"
+#include "fbx_vbomesh.h"
+
+namespace Fbx2Json
+{
+
+// Writes the baked meshes as a binary glTF 2.0 (.glb) file. The BIN chunk is
+// streamed straight from the VBOMesh vectors; only the glTF JSON document is
+// built in memory.
+class GlbExporter
+{
+  public:
+    GlbExporter();
+    GlbExporter(const Options & options);
+    void write(const std::string output, std::vector<VBOMesh *> * meshes);
+    ~GlbExporter();
+
+  private:
+    struct MeshLayout {
+      MeshLayout();
+      const VBOMesh * mesh;
+      // Non-empty vertex streams, each with its offset in the BIN chunk.
+      std::vector<MeshStream> attributes;
+      std::vector<size_t> attribute_offsets;
+      size_t indices_offset;
+      int first_buffer_view;
+      int first_accessor;
+      float min[3];
+      float max[3];
+    };
+
+    size_t layout_meshes(std::vector<VBOMesh *> * meshes, std::vector<MeshLayout> & layouts);
+    void write_document(JsonWriter & writer, const std::vector<MeshLayout> & layouts, size_t buffer_length);
+    void write_buffer_views(JsonWriter & writer, const std::vector<MeshLayout> & layouts);
+    void write_accessors(JsonWriter & writer, const std::vector<MeshLayout> & layouts);
+    void write_meshes(JsonWriter & writer, const std::vector<MeshLayout> & layouts);
+    bool write_binary_chunk(Sink & sink, const std::vector<MeshLayout> & layouts);
+
+    Options options;
+};
+
+} // namespace Fbx2Json
+
+#endif
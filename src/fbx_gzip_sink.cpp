@@ -0,0 +1,128 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <zlib.h>
+#include "fbx_gzip_sink.h"
+#include "fbx_parallel.h"
+
+namespace Fbx2Json
+{
+
+const size_t GZIP_BLOCK_SIZE = 1024 * 1024;
+
+// Blocks compressed per batch for each thread.
+const size_t GZIP_BLOCKS_PER_THREAD = 2;
+
+// zlib's windowBits for a deflate stream wrapped in a gzip header and trailer.
+const int GZIP_WINDOW_BITS = 15 + 16;
+
+GzipSink::GzipSink(Sink * destination, int level, int thread_count) : destination(destination), level(level),
+  thread_count(thread_count > 0 ? thread_count : hardware_thread_count()), pending(0), written(false), failed(false)
+{
+  blocks.resize(GZIP_BLOCKS_PER_THREAD * this->thread_count);
+}
+
+bool GzipSink::write(const char * data, size_t size)
+{
+  while(size > 0 && !failed) {
+    std::vector<char> & input = blocks[pending].input;
+
+    if(input.capacity() < GZIP_BLOCK_SIZE) {
+      input.reserve(GZIP_BLOCK_SIZE);
+    }
+
+    const size_t room = GZIP_BLOCK_SIZE - input.size();
+    const size_t chunk = size < room ? size : room;
+
+    input.insert(input.end(), data, data + chunk);
+    data += chunk;
+    size -= chunk;
+
+    if(input.size() == GZIP_BLOCK_SIZE && ++pending == blocks.size()) {
+      compress_pending();
+    }
+  }
+
+  return !failed;
+}
+
+// An empty output still gets one (empty) member, so that it is a valid gzip
+// file.
+bool GzipSink::close()
+{
+  if(pending < blocks.size() && (!blocks[pending].input.empty() || !written)) {
+    ++pending;
+  }
+
+  compress_pending();
+
+  return destination->close() && !failed;
+}
+
+bool GzipSink::compress_pending()
+{
+  parallel_for(pending, compress_task, this, thread_count);
+
+  for(size_t i = 0; i < pending; ++i) {
+    Block & block = blocks[i];
+
+    if(!block.compressed || !destination->write(reinterpret_cast<const char *>(&block.output[0]), block.output.size())) {
+      failed = true;
+    }
+
+    block.input.clear();
+    written = true;
+  }
+
+  pending = 0;
+
+  return !failed;
+}
+
+void GzipSink::compress_task(size_t index, void * context)
+{
+  GzipSink * sink = static_cast<GzipSink *>(context);
+  Block & block = sink->blocks[index];
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+
+  block.compressed = false;
+
+  if(deflateInit2(&stream, sink->level, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return;
+  }
+
+  block.output.resize(deflateBound(&stream, block.input.size()));
+
+  stream.next_in = reinterpret_cast<Bytef *>(block.input.empty() ? NULL : &block.input[0]);
+  stream.avail_in = static_cast<uInt>(block.input.size());
+  stream.next_out = &block.output[0];
+  stream.avail_out = static_cast<uInt>(block.output.size());
+
+  block.compressed = deflate(&stream, Z_FINISH) == Z_STREAM_END;
+  block.output.resize(stream.total_out);
+
+  deflateEnd(&stream);
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXGZIPSINK_H_
+#define FBX2JSON_FBXGZIPSINK_H_
+
+#include <vector>
+#include "fbx_sink.h"
+
+namespace Fbx2Json
+{
+
+// Gzip-compresses everything written to it into `destination`. The stream is
+// cut into blocks of GZIP_BLOCK_SIZE which are deflated independently, a
+// batch at a time across `thread_count` threads, and written out in order as
+// consecutive gzip members. Any gzip reader decodes the concatenation as a
+// single file. Memory use is bounded by the batch, never the whole output.
+class GzipSink : public Sink
+{
+  public:
+    GzipSink(Sink * destination, int level, int thread_count);
+    bool write(const char * data, size_t size);
+    bool close();
+
+  private:
+    struct Block {
+      std::vector<char> input;
+      std::vector<unsigned char> output;
+      bool compressed;
+    };
+
+    bool compress_pending();
+    static void compress_task(size_t index, void * context);
+
+    Sink * destination;
+    int level;
+    int thread_count;
+    std::vector<Block> blocks;
+    size_t pending;
+    bool written;
+    bool failed;
+};
+
+} // namespace Fbx2Json
+
+#endif
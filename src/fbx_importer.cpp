@@ -105,20 +105,20 @@ void Importer::normalise_scene()
     FbxSystemUnit::cm.ConvertScene(scene);
   }
 
-  // Convert mesh, NURBS and patch into triangle mesh
-  triangulate_recursive(scene->GetRootNode());
+  // Convert NURBS and patches into triangle meshes. Polygon meshes are
+  // triangulated as they are baked, see VBOMesh::initialize.
+  FbxGeometryConverter converter(sdk_manager);
+  triangulate_recursive(scene->GetRootNode(), converter);
 }
 
-void Importer::triangulate_recursive(FbxNode* node)
+void Importer::triangulate_recursive(FbxNode* node, FbxGeometryConverter& converter)
 {
   FbxNodeAttribute* node_attribute = node->GetNodeAttribute();
 
   if(node_attribute) {
-    if(node_attribute->GetAttributeType() == FbxNodeAttribute::eMesh ||
-        node_attribute->GetAttributeType() == FbxNodeAttribute::eNurbs ||
+    if(node_attribute->GetAttributeType() == FbxNodeAttribute::eNurbs ||
         node_attribute->GetAttributeType() == FbxNodeAttribute::eNurbsSurface ||
         node_attribute->GetAttributeType() == FbxNodeAttribute::ePatch) {
-      FbxGeometryConverter converter(node->GetFbxManager());
       converter.TriangulateInPlace(node);
     }
   }
@@ -126,7 +126,7 @@ void Importer::triangulate_recursive(FbxNode* node)
   const int child_count = node->GetChildCount();
 
   for(int i = 0; i < child_count; ++i) {
-    triangulate_recursive(node->GetChild(i));
+    triangulate_recursive(node->GetChild(i), converter);
   }
 }
 
@@ -44,7 +44,7 @@ class Importer
     void initialize_sdk_objects(FbxManager*& manager, FbxScene*& scene);
     void import_scene();
     void normalise_scene();
-    void triangulate_recursive(FbxNode* node);
+    void triangulate_recursive(FbxNode* node, FbxGeometryConverter& converter);
     void destroy_sdk_objects(FbxManager* manager, bool exit_status);
 
     FbxManager * sdk_manager;
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include "fbx_interleave.h"
+
+namespace Fbx2Json
+{
+
+static void add_attribute(InterleavedLayout & layout, const MeshStream & stream)
+{
+  const size_t value_size = stream.value_size();
+  const size_t offset = (layout.vertex_size + value_size - 1) / value_size * value_size;
+
+  layout.attributes.push_back(stream);
+  layout.offsets.push_back(offset);
+  layout.vertex_size = offset + stream.components * value_size;
+  layout.vertex_count = stream.count;
+}
+
+void layout_interleaved(const std::vector<MeshStream> & streams, const std::vector<std::string> & order, size_t alignment,
+                        InterleavedLayout & layout)
+{
+  std::vector<bool> placed(streams.size(), false);
+
+  for(std::vector<std::string>::const_iterator name = order.begin(); name != order.end(); ++name) {
+    for(size_t i = 0; i < streams.size(); ++i) {
+      if(!placed[i] && !streams[i].empty() && *name == streams[i].name) {
+        add_attribute(layout, streams[i]);
+        placed[i] = true;
+      }
+    }
+  }
+
+  for(size_t i = 0; i < streams.size(); ++i) {
+    if(!placed[i] && !streams[i].empty()) {
+      add_attribute(layout, streams[i]);
+    }
+  }
+
+  layout.vertex_size = (layout.vertex_size + alignment - 1) & ~(alignment - 1);
+}
+
+void interleave(const InterleavedLayout & layout, unsigned char * destination)
+{
+  memset(destination, 0, layout.vertex_count * layout.vertex_size);
+
+  for(size_t a = 0; a < layout.attributes.size(); ++a) {
+    const MeshStream & stream = layout.attributes[a];
+    const unsigned char * source = static_cast<const unsigned char *>(stream.data);
+    const size_t element_size = stream.components * stream.value_size();
+    unsigned char * output = destination + layout.offsets[a];
+
+    for(size_t v = 0; v < layout.vertex_count; ++v) {
+      memcpy(output + v * layout.vertex_size, source + v * stream.byte_stride(), element_size);
+    }
+  }
+}
+
+} // namespace Fbx2Json
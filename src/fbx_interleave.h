@@ -0,0 +1,58 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXINTERLEAVE_H_
+#define FBX2JSON_FBXINTERLEAVE_H_
+
+#include <string>
+#include <vector>
+#include "fbx_mesh_stream.h"
+
+namespace Fbx2Json
+{
+
+// Placement of a mesh's vertex streams within one interleaved vertex. Only
+// the `components` values of each element are kept (no W for positions),
+// each attribute starts on a multiple of its value size and the vertex size
+// is rounded up to `alignment` bytes; gaps are zero.
+struct InterleavedLayout {
+  InterleavedLayout() : vertex_size(0), vertex_count(0) {}
+
+  size_t vertex_size;
+  size_t vertex_count;
+  std::vector<MeshStream> attributes;
+  std::vector<size_t> offsets;
+};
+
+// Lays out the non-empty streams, those named in `order` first and in that
+// order, then the others in the order given. `alignment` must be a power of
+// two of at least 4, so that every attribute stays aligned from one vertex
+// to the next.
+void layout_interleaved(const std::vector<MeshStream> & streams, const std::vector<std::string> & order, size_t alignment,
+                        InterleavedLayout & layout);
+
+// Writes vertex_count * vertex_size bytes.
+void interleave(const InterleavedLayout & layout, unsigned char * destination);
+
+} // namespace Fbx2Json
+
+#endif
@@ -0,0 +1,396 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "fbx_float_format.h"
+#include "fbx_json_writer.h"
+
+namespace Fbx2Json
+{
+
+const size_t WRITER_BUFFER_SIZE = 256 * 1024;
+
+JsonWriter::JsonWriter(Sink * sink, bool indent) : sink(sink), indent(indent), buffer(WRITER_BUFFER_SIZE), used(0), after_key(false), failed(false)
+{
+
+}
+
+JsonWriter::JsonWriter(Sink * sink, const JsonWriter & parent, int position) : sink(sink), indent(parent.indent),
+  buffer(WRITER_BUFFER_SIZE), used(0), counts(parent.counts), after_key(false), failed(false)
+{
+  if(!counts.empty()) {
+    counts.back() = position;
+  }
+}
+
+void JsonWriter::begin_object()
+{
+  separate();
+  put('{');
+  counts.push_back(0);
+}
+
+void JsonWriter::end_object()
+{
+  const int count = counts.back();
+  counts.pop_back();
+
+  if(count > 0) {
+    newline();
+  }
+
+  put('}');
+}
+
+void JsonWriter::begin_array()
+{
+  separate();
+  put('[');
+  counts.push_back(0);
+}
+
+void JsonWriter::end_array()
+{
+  const int count = counts.back();
+  counts.pop_back();
+
+  if(count > 0) {
+    newline();
+  }
+
+  put(']');
+}
+
+void JsonWriter::key(const char * name)
+{
+  separate();
+  put_string(name);
+
+  if(indent) {
+    put(" : ", 3);
+  } else {
+    put(':');
+  }
+
+  after_key = true;
+}
+
+void JsonWriter::value(int number)
+{
+  separate();
+
+  if(number < 0) {
+    put('-');
+    put_uint(0u - static_cast<unsigned int>(number));
+  } else {
+    put_uint(static_cast<unsigned int>(number));
+  }
+}
+
+void JsonWriter::value(unsigned int number)
+{
+  separate();
+  put_uint(number);
+}
+
+void JsonWriter::value(unsigned long number)
+{
+  separate();
+  put_uint(number);
+}
+
+void JsonWriter::value(unsigned long long number)
+{
+  separate();
+  put_uint(number);
+}
+
+void JsonWriter::value(float number)
+{
+  separate();
+  put_float(number, -1);
+}
+
+void JsonWriter::value(bool flag)
+{
+  separate();
+
+  if(flag) {
+    put("true", 4);
+  } else {
+    put("false", 5);
+  }
+}
+
+void JsonWriter::value(const char * text)
+{
+  value(std::string(text));
+}
+
+void JsonWriter::value(const std::string & text)
+{
+  separate();
+  put_string(text);
+}
+
+void JsonWriter::put_string(const std::string & text)
+{
+  put('"');
+
+  for(std::string::const_iterator c = text.begin(); c != text.end(); ++c) {
+    switch(*c) {
+      case '"':
+        put("\\\"", 2);
+        break;
+
+      case '\\':
+        put("\\\\", 2);
+        break;
+
+      case '\n':
+        put("\\n", 2);
+        break;
+
+      case '\r':
+        put("\\r", 2);
+        break;
+
+      case '\t':
+        put("\\t", 2);
+        break;
+
+      default:
+        if(static_cast<unsigned char>(*c) < 0x20) {
+          char escaped[8];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(*c));
+          put(escaped, 6);
+        } else {
+          put(*c);
+        }
+    }
+  }
+
+  put('"');
+}
+
+void JsonWriter::float_array(const float * data, size_t count, int components, int stride, int precision)
+{
+  begin_array();
+
+  for(size_t i = 0; i < count; ++i) {
+    const float * element = data + i * stride;
+
+    for(int j = 0; j < components; ++j) {
+      separate();
+      put_float(element[j], precision);
+    }
+  }
+
+  end_array();
+}
+
+void JsonWriter::uint_array(const unsigned int * data, size_t count)
+{
+  begin_array();
+
+  for(size_t i = 0; i < count; ++i) {
+    separate();
+    put_uint(data[i]);
+  }
+
+  end_array();
+}
+
+template <typename T>
+static void write_integers(JsonWriter & writer, const MeshStream & stream)
+{
+  const T * data = static_cast<const T *>(stream.data);
+
+  for(size_t i = 0; i < stream.count; ++i) {
+    for(int j = 0; j < stream.components; ++j) {
+      writer.value(static_cast<int>(data[i * stream.stride + j]));
+    }
+  }
+}
+
+void JsonWriter::stream_array(const MeshStream & stream, int precision)
+{
+  switch(stream.format) {
+    case MeshStream::FORMAT_FLOAT32:
+      float_array(static_cast<const float *>(stream.data), stream.count, stream.components, stream.stride, precision);
+      break;
+
+    case MeshStream::FORMAT_UINT32:
+      if(stream.components == stream.stride) {
+        uint_array(static_cast<const unsigned int *>(stream.data), stream.count * stream.components);
+        break;
+      }
+
+      begin_array();
+
+      for(size_t i = 0; i < stream.count; ++i) {
+        for(int j = 0; j < stream.components; ++j) {
+          separate();
+          put_uint(static_cast<const unsigned int *>(stream.data)[i * stream.stride + j]);
+        }
+      }
+
+      end_array();
+      break;
+
+    case MeshStream::FORMAT_INT8:
+      begin_array();
+      write_integers<signed char>(*this, stream);
+      end_array();
+      break;
+
+    case MeshStream::FORMAT_INT16:
+      begin_array();
+      write_integers<short>(*this, stream);
+      end_array();
+      break;
+
+    case MeshStream::FORMAT_UINT8:
+      begin_array();
+      write_integers<unsigned char>(*this, stream);
+      end_array();
+      break;
+
+    case MeshStream::FORMAT_UINT16:
+      begin_array();
+      write_integers<unsigned short>(*this, stream);
+      end_array();
+      break;
+  }
+}
+
+void JsonWriter::append_values(const char * data, size_t size, int count)
+{
+  put(data, size);
+
+  if(!counts.empty()) {
+    counts.back() += count;
+  }
+}
+
+bool JsonWriter::flush()
+{
+  if(used > 0 && !failed) {
+    failed = !sink->write(&buffer[0], used);
+  }
+
+  used = 0;
+
+  return !failed;
+}
+
+// Emits whatever has to precede a new value: the separator from the previous
+// sibling and, when indenting, a line break at the current depth.
+void JsonWriter::separate()
+{
+  if(after_key) {
+    after_key = false;
+    return;
+  }
+
+  if(counts.empty()) {
+    return;
+  }
+
+  if(counts.back()++ > 0) {
+    put(',');
+  }
+
+  newline();
+}
+
+void JsonWriter::newline()
+{
+  if(!indent) {
+    return;
+  }
+
+  put('\n');
+
+  for(size_t i = 0; i < counts.size(); ++i) {
+    put('\t');
+  }
+}
+
+void JsonWriter::put(char c)
+{
+  if(used == buffer.size()) {
+    flush();
+  }
+
+  buffer[used++] = c;
+}
+
+void JsonWriter::put(const char * data, size_t size)
+{
+  if(used + size > buffer.size()) {
+    flush();
+
+    if(size > buffer.size()) {
+      failed = failed || !sink->write(data, size);
+      return;
+    }
+  }
+
+  memcpy(&buffer[used], data, size);
+  used += size;
+}
+
+void JsonWriter::put_float(float number, int precision)
+{
+  if(used + FLOAT_FORMAT_BUFFER_SIZE > buffer.size()) {
+    flush();
+  }
+
+  if(precision < 0) {
+    used += format_float_shortest(number, &buffer[used]);
+  } else {
+    used += format_float_fixed(number, precision, &buffer[used]);
+  }
+}
+
+void JsonWriter::put_uint(unsigned long long number)
+{
+  char digits[24];
+  char * end = digits + sizeof(digits);
+  char * p = end;
+
+  do {
+    *--p = static_cast<char>('0' + number % 10);
+    number /= 10;
+  } while(number != 0);
+
+  put(p, end - p);
+}
+
+JsonWriter::~JsonWriter()
+{
+  flush();
+}
+
+} // namespace Fbx2Json
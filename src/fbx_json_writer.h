@@ -0,0 +1,98 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXJSONWRITER_H_
+#define FBX2JSON_FBXJSONWRITER_H_
+
+#include <string>
+#include <vector>
+#include "fbx_mesh_stream.h"
+#include "fbx_sink.h"
+
+namespace Fbx2Json
+{
+
+// Streaming JSON writer. Values are formatted straight into a staging buffer
+// which is handed to the sink whenever it fills up, so memory use stays
+// constant regardless of how much data is written. The indented layout
+// matches JsonBox::Value::writeToStream so existing output is unchanged.
+class JsonWriter
+{
+  public:
+    JsonWriter(Sink * sink, bool indent = true);
+    // Writer for a value that will sit at `position` in the container
+    // `parent` currently has open. Its output is spliced back with
+    // parent.append_values(), so values can be formatted on other threads
+    // and still come out exactly as if `parent` had written them.
+    JsonWriter(Sink * sink, const JsonWriter & parent, int position);
+    ~JsonWriter();
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+    void key(const char * name);
+
+    void value(int number);
+    void value(unsigned int number);
+    void value(unsigned long number);
+    void value(unsigned long long number);
+    void value(float number);
+    void value(bool flag);
+    void value(const char * text);
+    void value(const std::string & text);
+
+    // Writes `count` elements of `components` floats each, where consecutive
+    // elements are `stride` floats apart. Trailing components are skipped.
+    // `precision` is the number of fractional digits, -1 for shortest.
+    void float_array(const float * data, size_t count, int components, int stride, int precision = -1);
+    void uint_array(const unsigned int * data, size_t count);
+    // Writes the components of every element of `stream` as one flat array;
+    // `precision` applies to float streams.
+    void stream_array(const MeshStream & stream, int precision = -1);
+
+    // Adds `count` values produced by fragment writers, in order.
+    void append_values(const char * data, size_t size, int count);
+
+    bool flush();
+
+  private:
+    void separate();
+    void newline();
+    void put(char c);
+    void put(const char * data, size_t size);
+    void put_string(const std::string & text);
+    void put_float(float number, int precision);
+    void put_uint(unsigned long long number);
+
+    Sink * sink;
+    bool indent;
+    std::vector<char> buffer;
+    size_t used;
+    std::vector<int> counts;
+    bool after_key;
+    bool failed;
+};
+
+} // namespace Fbx2Json
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "fbx_layer_element.h"
+
+namespace Fbx2Json
+{
+
+// Index into the element's data (the index array when it has one) of every
+// corner. Each mapping mode gets its own loop so that none of them branch.
+static bool map_corners(const FbxLayerElement::EMappingMode mapping_mode, const FbxMesh * mesh, int * keys,
+                        const int corner_count)
+{
+  const int * polygon_vertices = mesh->GetPolygonVertices();
+
+  switch(mapping_mode) {
+    case FbxLayerElement::eByControlPoint:
+      for(int c = 0; c < corner_count; ++c) {
+        keys[c] = polygon_vertices[c];
+      }
+
+      return true;
+
+    case FbxLayerElement::eByPolygonVertex:
+      for(int c = 0; c < corner_count; ++c) {
+        keys[c] = c;
+      }
+
+      return true;
+
+    case FbxLayerElement::eByPolygon:
+      for(int p = 0; p < mesh->GetPolygonCount(); ++p) {
+        const int first = mesh->GetPolygonVertexIndex(p);
+        const int size = mesh->GetPolygonSize(p);
+
+        for(int c = first; c < first + size; ++c) {
+          keys[c] = p;
+        }
+      }
+
+      return true;
+
+    case FbxLayerElement::eAllSame:
+      for(int c = 0; c < corner_count; ++c) {
+        keys[c] = 0;
+      }
+
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+static bool map_control_points(const FbxLayerElement::EMappingMode mapping_mode, int * keys, const int control_point_count)
+{
+  switch(mapping_mode) {
+    case FbxLayerElement::eByControlPoint:
+      for(int i = 0; i < control_point_count; ++i) {
+        keys[i] = i;
+      }
+
+      return true;
+
+    case FbxLayerElement::eAllSame:
+      for(int i = 0; i < control_point_count; ++i) {
+        keys[i] = 0;
+      }
+
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+// Replaces each key by the value it points to in `table`, reporting whether
+// they all were in range. The check accumulates rather than branches.
+static bool lookup(int * keys, const size_t key_count, const int * table, const int table_size)
+{
+  if(table_size == 0) {
+    return false;
+  }
+
+  unsigned int invalid = 0;
+
+  for(size_t i = 0; i < key_count; ++i) {
+    const unsigned int key = static_cast<unsigned int>(keys[i]);
+    invalid |= key >= static_cast<unsigned int>(table_size);
+    keys[i] = table[invalid ? 0 : key];
+  }
+
+  return invalid == 0;
+}
+
+static bool check_range(const int * keys, const size_t key_count, const int size)
+{
+  unsigned int invalid = 0;
+
+  for(size_t i = 0; i < key_count; ++i) {
+    invalid |= static_cast<unsigned int>(keys[i]) >= static_cast<unsigned int>(size);
+  }
+
+  return invalid == 0;
+}
+
+bool resolve_element(const FbxLayerElement * element, FbxLayerElementArrayTemplate<int> & index_array, const int direct_count,
+                     const FbxMesh * mesh, const bool by_control_point, std::vector<int> & direct_indices)
+{
+  const FbxLayerElement::EMappingMode mapping_mode = element->GetMappingMode();
+  bool mapped = false;
+
+  if(by_control_point) {
+    direct_indices.resize(mesh->GetControlPointsCount());
+    mapped = direct_indices.empty() || map_control_points(mapping_mode, &direct_indices[0], static_cast<int>(direct_indices.size()));
+  } else {
+    direct_indices.resize(mesh->GetPolygonVertexCount());
+    mapped = direct_indices.empty() || map_corners(mapping_mode, mesh, &direct_indices[0],
+                                                   static_cast<int>(direct_indices.size()));
+  }
+
+  if(!mapped || direct_indices.empty()) {
+    return mapped;
+  }
+
+  switch(element->GetReferenceMode()) {
+    case FbxLayerElement::eDirect:
+      return check_range(&direct_indices[0], direct_indices.size(), direct_count);
+
+    case FbxLayerElement::eIndex:
+    case FbxLayerElement::eIndexToDirect: {
+      FbxLayerElementArrayReadLock<int> lock(index_array);
+
+      return lock.GetData() != NULL &&
+             lookup(&direct_indices[0], direct_indices.size(), lock.GetData(), index_array.GetCount()) &&
+             check_range(&direct_indices[0], direct_indices.size(), direct_count);
+    }
+
+    default:
+      return false;
+  }
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXLAYERELEMENT_H_
+#define FBX2JSON_FBXLAYERELEMENT_H_
+
+#include <vector>
+#include <fbxsdk.h>
+#include "fbx_convert.h"
+
+namespace Fbx2Json
+{
+
+// Bulk access to FBX layer elements (normals, uvs, ...). Mapping and
+// reference modes are resolved once per element into the direct array entry
+// used by each corner or control point, instead of once per value through
+// calls such as FbxMesh::GetPolygonVertexNormal.
+
+// Fills `direct_indices` with the entry of the direct array used by each
+// corner, corner `k` of polygon `p` being GetPolygonVertexIndex(p) + k as in
+// GetPolygonVertices(), or by each control point when `by_control_point` is
+// set (which only eByControlPoint and eAllSame elements can provide).
+// Returns false, leaving `direct_indices` unspecified, for unsupported modes
+// and out-of-range indices.
+bool resolve_element(const FbxLayerElement * element, FbxLayerElementArrayTemplate<int> & index_array, int direct_count,
+                     const FbxMesh * mesh, bool by_control_point, std::vector<int> & direct_indices);
+
+template<typename T>
+bool resolve_element(const FbxLayerElementTemplate<T> * element, const FbxMesh * mesh, bool by_control_point,
+                     std::vector<int> & direct_indices)
+{
+  return resolve_element(element, element->GetIndexArray(), element->GetDirectArray().GetCount(), mesh, by_control_point,
+                         direct_indices);
+}
+
+// Writes the first `components` values of each resolved direct array entry
+// as floats, `stride` floats apart. Every element type used (FbxVector2,
+// FbxVector4, FbxColor) is a plain run of doubles.
+template<typename T>
+bool gather_element(const FbxLayerElementTemplate<T> * element, const std::vector<int> & direct_indices, int components,
+                    float * destination, int stride)
+{
+  FbxLayerElementArrayReadLock<T> lock(element->GetDirectArray());
+  const T * direct = lock.GetData();
+
+  if(direct == NULL) {
+    return false;
+  }
+
+  if(!direct_indices.empty()) {
+    convert_vectors(destination, stride, components, reinterpret_cast<const double *>(direct),
+                    static_cast<int>(sizeof(T) / sizeof(double)), &direct_indices[0], direct_indices.size());
+  }
+
+  return true;
+}
+
+} // namespace Fbx2Json
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXMESHSTREAM_H_
+#define FBX2JSON_FBXMESHSTREAM_H_
+
+#include <cstddef>
+#include <cstring>
+
+namespace Fbx2Json
+{
+
+// Typed view of one of a mesh's arrays: `count` elements of `components`
+// values each, consecutive elements starting `stride` values apart. Trailing
+// values of an element that fall outside `components` (the W of positions)
+// are padding. Exporters consume meshes through these views only, so a new
+// attribute needs no exporter code of its own.
+struct MeshStream {
+  enum Semantic {
+    // Hierarchy nodes and triangle table, see fbx_bvh_query.h.
+    SEMANTIC_BVH,
+    SEMANTIC_COLOR,
+    SEMANTIC_INDEX,
+    // Raw bytes holding several attributes, see fbx_interleave.h.
+    SEMANTIC_INTERLEAVED,
+    // Meshlet tables and bounds, see fbx_meshlet.h.
+    SEMANTIC_MESHLET,
+    SEMANTIC_NORMAL,
+    SEMANTIC_POSITION,
+    SEMANTIC_TANGENT,
+    SEMANTIC_TEXCOORD,
+  };
+
+  enum Format {
+    FORMAT_FLOAT32,
+    FORMAT_INT8,
+    FORMAT_INT16,
+    FORMAT_UINT8,
+    FORMAT_UINT16,
+    FORMAT_UINT32,
+  };
+
+  MeshStream(const char * name, Semantic semantic, Format format, int components, int stride, size_t count, const void * data,
+             int set = 0) :
+    name(name), semantic(semantic), format(format), components(components), stride(stride), count(count), data(data),
+    set(set) {}
+
+  size_t value_size() const {
+    switch(format) {
+      case FORMAT_INT8:
+      case FORMAT_UINT8:
+        return 1;
+
+      case FORMAT_INT16:
+      case FORMAT_UINT16:
+        return 2;
+
+      default:
+        return 4;
+    }
+  }
+  // Component type as named in the binary output's descriptor.
+  const char * type_name() const {
+    switch(format) {
+      case FORMAT_INT8:
+        return "int8";
+
+      case FORMAT_INT16:
+        return "int16";
+
+      case FORMAT_UINT8:
+        return "uint8";
+
+      case FORMAT_UINT16:
+        return "uint16";
+
+      case FORMAT_UINT32:
+        return "uint32";
+
+      default:
+        return "float32";
+    }
+  }
+  size_t byte_stride() const {
+    return stride * value_size();
+  }
+  size_t byte_length() const {
+    return count * byte_stride();
+  }
+  bool empty() const {
+    return count == 0;
+  }
+
+  // Name of the stream in the JSON and binary outputs.
+  const char * name;
+  Semantic semantic;
+  Format format;
+  int components;
+  int stride;
+  size_t count;
+  const void * data;
+  // Which uv set or colour layer this is, for semantics that have several.
+  int set;
+};
+
+// Orders streams by name, the order JsonBox wrote object keys in.
+inline bool stream_name_less(const MeshStream & a, const MeshStream & b)
+{
+  return strcmp(a.name, b.name) < 0;
+}
+
+} // namespace Fbx2Json
+
+#endif
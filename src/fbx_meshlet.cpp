@@ -0,0 +1,633 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "fbx_meshlet.h"
+
+namespace Fbx2Json
+{
+
+// How much a triangle's normal straying from the meshlet's average counts
+// against it, relative to its distance: higher values give tighter cones
+// and looser spheres.
+static const float MESHLET_CONE_WEIGHT = 0.25f;
+
+// Cones whose normals spread nearly as far as a hemisphere cull too little
+// to be worth testing.
+static const float MESHLET_MIN_CONE_DOT = 0.1f;
+
+static const unsigned int NO_TRIANGLE = ~0u;
+static const unsigned char NOT_IN_MESHLET = 0xff;
+
+// Triangles around each vertex: those of vertex v not yet in a meshlet are
+// the first counts[v] entries of `triangles` from offsets[v] on. Triangles
+// are swapped out of that range as they are placed.
+struct MeshletAdjacency {
+  std::vector<unsigned int> counts;
+  std::vector<unsigned int> offsets;
+  std::vector<unsigned int> triangles;
+};
+
+static bool is_degenerate(const unsigned int * triangle)
+{
+  return triangle[0] == triangle[1] || triangle[0] == triangle[2] || triangle[1] == triangle[2];
+}
+
+static void build_adjacency(MeshletAdjacency & adjacency, const unsigned int * indices, size_t triangle_count,
+                            size_t vertex_count)
+{
+  adjacency.counts.assign(vertex_count, 0);
+  adjacency.offsets.resize(vertex_count);
+
+  for(size_t t = 0; t < triangle_count; ++t) {
+    if(!is_degenerate(&indices[t * 3])) {
+      for(int k = 0; k < 3; ++k) {
+        ++adjacency.counts[indices[t * 3 + k]];
+      }
+    }
+  }
+
+  unsigned int offset = 0;
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    adjacency.offsets[v] = offset;
+    offset += adjacency.counts[v];
+    adjacency.counts[v] = 0;
+  }
+
+  adjacency.triangles.resize(offset);
+
+  for(size_t t = 0; t < triangle_count; ++t) {
+    if(!is_degenerate(&indices[t * 3])) {
+      for(int k = 0; k < 3; ++k) {
+        const unsigned int v = indices[t * 3 + k];
+        adjacency.triangles[adjacency.offsets[v] + adjacency.counts[v]++] = static_cast<unsigned int>(t);
+      }
+    }
+  }
+}
+
+static void remove_triangle(MeshletAdjacency & adjacency, const unsigned int * triangle, unsigned int t)
+{
+  for(int k = 0; k < 3; ++k) {
+    unsigned int * live = &adjacency.triangles[adjacency.offsets[triangle[k]]];
+    unsigned int & count = adjacency.counts[triangle[k]];
+
+    for(unsigned int i = 0; i < count; ++i) {
+      if(live[i] == t) {
+        live[i] = live[count - 1];
+        --count;
+        break;
+      }
+    }
+  }
+}
+
+static void normalize(float * vector)
+{
+  const float length = sqrtf(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+
+  for(int k = 0; k < 3 && length > 0; ++k) {
+    vector[k] /= length;
+  }
+}
+
+// Unit normal of a triangle, zero when it has no area.
+static void triangle_normal(float * normal, const float * a, const float * b, const float * c)
+{
+  const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+  const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+  normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+  normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+  normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+  normalize(normal);
+}
+
+static void compute_triangle_frames(std::vector<float> & centroids, std::vector<float> & normals, const unsigned int * indices,
+                                    size_t triangle_count, const float * positions, size_t position_stride)
+{
+  centroids.resize(triangle_count * 3);
+  normals.resize(triangle_count * 3);
+
+  for(size_t t = 0; t < triangle_count; ++t) {
+    const float * a = &positions[indices[t * 3] * position_stride];
+    const float * b = &positions[indices[t * 3 + 1] * position_stride];
+    const float * c = &positions[indices[t * 3 + 2] * position_stride];
+
+    for(int k = 0; k < 3; ++k) {
+      centroids[t * 3 + k] = (a[k] + b[k] + c[k]) / 3.f;
+    }
+
+    triangle_normal(&normals[t * 3], a, b, c);
+  }
+}
+
+// Triangle centroids split at the median of their widest axis down to
+// leaves of a few triangles. Each node counts the triangles below it not yet
+// in a meshlet, so that searches skip the parts already used up.
+struct MeshletTreeNode {
+  float split;
+  int axis;
+  unsigned int first;
+  unsigned int count;
+  unsigned int children[2];
+  unsigned int parent;
+  unsigned int live;
+};
+
+// A triangle and its centroid, kept together so that partitioning does not
+// chase indices.
+struct MeshletTreeItem {
+  float centroid[3];
+  unsigned int triangle;
+};
+
+struct MeshletTree {
+  std::vector<MeshletTreeNode> nodes;
+  std::vector<MeshletTreeItem> items;
+  std::vector<unsigned int> leaves;
+};
+
+static const int MESHLET_TREE_LEAF = 3;
+static const unsigned int MESHLET_TREE_LEAF_SIZE = 8;
+
+struct CentroidLess {
+  CentroidLess(int axis) : axis(axis) {}
+
+  bool operator()(const MeshletTreeItem & a, const MeshletTreeItem & b) const {
+    return a.centroid[axis] < b.centroid[axis];
+  }
+
+  int axis;
+};
+
+static unsigned int build_tree_node(MeshletTree & tree, unsigned int first, unsigned int count, unsigned int parent)
+{
+  const unsigned int index = static_cast<unsigned int>(tree.nodes.size());
+  MeshletTreeNode node;
+
+  node.split = 0.f;
+  node.axis = MESHLET_TREE_LEAF;
+  node.first = first;
+  node.count = count;
+  node.children[0] = node.children[1] = 0;
+  node.parent = parent;
+  node.live = count;
+  tree.nodes.push_back(node);
+
+  if(count <= MESHLET_TREE_LEAF_SIZE) {
+    for(unsigned int i = first; i < first + count; ++i) {
+      tree.leaves[tree.items[i].triangle] = index;
+    }
+
+    return index;
+  }
+
+  float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+  for(unsigned int i = first; i < first + count; ++i) {
+    for(int k = 0; k < 3; ++k) {
+      minimum[k] = std::min(minimum[k], tree.items[i].centroid[k]);
+      maximum[k] = std::max(maximum[k], tree.items[i].centroid[k]);
+    }
+  }
+
+  int axis = 0;
+
+  for(int k = 1; k < 3; ++k) {
+    if(maximum[k] - minimum[k] > maximum[axis] - minimum[axis]) {
+      axis = k;
+    }
+  }
+
+  const unsigned int half = count / 2;
+  const std::vector<MeshletTreeItem>::iterator begin = tree.items.begin() + first;
+  std::nth_element(begin, begin + half, begin + count, CentroidLess(axis));
+
+  tree.nodes[index].axis = axis;
+  tree.nodes[index].split = tree.items[first + half].centroid[axis];
+
+  const unsigned int left = build_tree_node(tree, first, half, index);
+  const unsigned int right = build_tree_node(tree, first + half, count - half, index);
+
+  tree.nodes[index].children[0] = left;
+  tree.nodes[index].children[1] = right;
+
+  return index;
+}
+
+static void build_tree(MeshletTree & tree, const std::vector<float> & centroids, const std::vector<unsigned char> & placed)
+{
+  tree.leaves.assign(placed.size(), 0);
+
+  for(size_t t = 0; t < placed.size(); ++t) {
+    if(!placed[t]) {
+      MeshletTreeItem item;
+      std::copy(&centroids[t * 3], &centroids[t * 3] + 3, item.centroid);
+      item.triangle = static_cast<unsigned int>(t);
+      tree.items.push_back(item);
+    }
+  }
+
+  if(!tree.items.empty()) {
+    build_tree_node(tree, 0, static_cast<unsigned int>(tree.items.size()), 0);
+  }
+}
+
+static void remove_from_tree(MeshletTree & tree, unsigned int t)
+{
+  unsigned int node = tree.leaves[t];
+
+  for(;;) {
+    --tree.nodes[node].live;
+
+    if(node == 0) {
+      break;
+    }
+
+    node = tree.nodes[node].parent;
+  }
+}
+
+// The unplaced triangle whose centroid lies nearest `point`, if it is closer
+// than `best_distance` (squared).
+static void find_nearest(const MeshletTree & tree, unsigned int node_index, const std::vector<unsigned char> & placed,
+                         const float * point, unsigned int & best, float & best_distance)
+{
+  const MeshletTreeNode & node = tree.nodes[node_index];
+
+  if(node.live == 0) {
+    return;
+  }
+
+  if(node.axis == MESHLET_TREE_LEAF) {
+    for(unsigned int i = node.first; i < node.first + node.count; ++i) {
+      const unsigned int t = tree.items[i].triangle;
+      const float * centroid = tree.items[i].centroid;
+      const float offset[3] = { centroid[0] - point[0], centroid[1] - point[1], centroid[2] - point[2] };
+      const float distance = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+
+      if(!placed[t] && distance < best_distance) {
+        best = t;
+        best_distance = distance;
+      }
+    }
+
+    return;
+  }
+
+  const float offset = point[node.axis] - node.split;
+  const int near_side = offset < 0 ? 0 : 1;
+
+  find_nearest(tree, node.children[near_side], placed, point, best, best_distance);
+
+  if(offset * offset < best_distance) {
+    find_nearest(tree, node.children[1 - near_side], placed, point, best, best_distance);
+  }
+}
+
+// The meshlet being grown: its table entries so far, and the sums of its
+// triangles' centroids and normals.
+struct MeshletGrowth {
+  Meshlet meshlet;
+  float centroid_sum[3];
+  float normal_sum[3];
+};
+
+static void start_meshlet(MeshletGrowth & growth, const std::vector<unsigned int> & meshlet_vertices,
+                          const std::vector<unsigned char> & meshlet_triangles)
+{
+  growth.meshlet.vertex_offset = static_cast<unsigned int>(meshlet_vertices.size());
+  growth.meshlet.vertex_count = 0;
+  growth.meshlet.triangle_offset = static_cast<unsigned int>(meshlet_triangles.size() / 3);
+  growth.meshlet.triangle_count = 0;
+
+  for(int k = 0; k < 3; ++k) {
+    growth.centroid_sum[k] = 0.f;
+    growth.normal_sum[k] = 0.f;
+  }
+}
+
+static void finish_meshlet(std::vector<Meshlet> & meshlets, const MeshletGrowth & growth,
+                           const std::vector<unsigned int> & meshlet_vertices, std::vector<unsigned char> & local)
+{
+  const Meshlet & meshlet = growth.meshlet;
+
+  for(unsigned int i = 0; i < meshlet.vertex_count; ++i) {
+    local[meshlet_vertices[meshlet.vertex_offset + i]] = NOT_IN_MESHLET;
+  }
+
+  meshlets.push_back(meshlet);
+}
+
+static unsigned int count_new_vertices(const unsigned int * triangle, const std::vector<unsigned char> & local)
+{
+  return (local[triangle[0]] == NOT_IN_MESHLET) + (local[triangle[1]] == NOT_IN_MESHLET) +
+         (local[triangle[2]] == NOT_IN_MESHLET);
+}
+
+// The unplaced triangle around the meshlet's vertices that adds the fewest
+// vertices and, among those, scores lowest on distance from the meshlet's
+// centroid, stretched by how far its normal strays from the meshlet's.
+static unsigned int pick_adjacent_triangle(const MeshletGrowth & growth, const MeshletAdjacency & adjacency,
+                                           const unsigned int * indices, const std::vector<unsigned int> & meshlet_vertices,
+                                           const std::vector<unsigned char> & local, const std::vector<float> & centroids,
+                                           const std::vector<float> & normals)
+{
+  const Meshlet & meshlet = growth.meshlet;
+  float centroid[3];
+  float axis[3];
+
+  for(int k = 0; k < 3; ++k) {
+    centroid[k] = growth.centroid_sum[k] / meshlet.triangle_count;
+    axis[k] = growth.normal_sum[k];
+  }
+
+  normalize(axis);
+
+  unsigned int best = NO_TRIANGLE;
+  unsigned int best_extra = 4;
+  float best_score = FLT_MAX;
+
+  for(unsigned int i = 0; i < meshlet.vertex_count; ++i) {
+    const unsigned int v = meshlet_vertices[meshlet.vertex_offset + i];
+    const unsigned int * live = &adjacency.triangles[adjacency.offsets[v]];
+
+    for(unsigned int j = 0; j < adjacency.counts[v]; ++j) {
+      const unsigned int t = live[j];
+      const unsigned int extra = count_new_vertices(&indices[t * 3], local);
+
+      if(extra > best_extra) {
+        continue;
+      }
+
+      const float * position = &centroids[t * 3];
+      const float * normal = &normals[t * 3];
+      const float offset[3] = { position[0] - centroid[0], position[1] - centroid[1], position[2] - centroid[2] };
+      const float distance = sqrtf(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+      const float spread = 1.f - (normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2]);
+      const float score = distance * (1.f + MESHLET_CONE_WEIGHT * spread);
+
+      if(extra < best_extra || score < best_score) {
+        best = t;
+        best_extra = extra;
+        best_score = score;
+      }
+    }
+  }
+
+  return best;
+}
+
+size_t build_meshlets(std::vector<Meshlet> & meshlets, std::vector<unsigned int> & meshlet_vertices,
+                      std::vector<unsigned char> & meshlet_triangles, const unsigned int * indices, size_t index_count,
+                      const float * positions, size_t vertex_count, size_t position_stride,
+                      size_t max_vertices, size_t max_triangles)
+{
+  const size_t triangle_count = index_count / 3;
+  const size_t first_meshlet = meshlets.size();
+
+  max_vertices = std::min(max_vertices, static_cast<size_t>(NOT_IN_MESHLET));
+
+  MeshletAdjacency adjacency;
+  build_adjacency(adjacency, indices, triangle_count, vertex_count);
+
+  std::vector<float> centroids;
+  std::vector<float> normals;
+  compute_triangle_frames(centroids, normals, indices, triangle_count, positions, position_stride);
+
+  std::vector<unsigned char> placed(triangle_count, 0);
+  std::vector<unsigned char> local(vertex_count, NOT_IN_MESHLET);
+
+  for(size_t t = 0; t < triangle_count; ++t) {
+    placed[t] = is_degenerate(&indices[t * 3]);
+  }
+
+  MeshletTree tree;
+  build_tree(tree, centroids, placed);
+
+  if(tree.items.empty()) {
+    return 0;
+  }
+
+  MeshletGrowth growth;
+  start_meshlet(growth, meshlet_vertices, meshlet_triangles);
+
+  for(;;) {
+    unsigned int t = NO_TRIANGLE;
+
+    if(growth.meshlet.triangle_count > 0) {
+      t = pick_adjacent_triangle(growth, adjacency, indices, meshlet_vertices, local, centroids, normals);
+    }
+
+    // Nothing adjacent is left: carry on from the triangle nearest the
+    // meshlet, or the first one to start with.
+    if(t == NO_TRIANGLE) {
+      float point[3];
+      float best_distance = FLT_MAX;
+
+      for(int k = 0; k < 3; ++k) {
+        point[k] = growth.meshlet.triangle_count > 0 ? growth.centroid_sum[k] / growth.meshlet.triangle_count :
+                   tree.items[0].centroid[k];
+      }
+
+      find_nearest(tree, 0, placed, point, t, best_distance);
+
+      if(t == NO_TRIANGLE) {
+        break;
+      }
+    }
+
+    const unsigned int * triangle = &indices[t * 3];
+
+    if(growth.meshlet.vertex_count + count_new_vertices(triangle, local) > max_vertices ||
+       growth.meshlet.triangle_count == max_triangles) {
+      finish_meshlet(meshlets, growth, meshlet_vertices, local);
+      start_meshlet(growth, meshlet_vertices, meshlet_triangles);
+    }
+
+    for(int k = 0; k < 3; ++k) {
+      if(local[triangle[k]] == NOT_IN_MESHLET) {
+        local[triangle[k]] = static_cast<unsigned char>(growth.meshlet.vertex_count++);
+        meshlet_vertices.push_back(triangle[k]);
+      }
+
+      meshlet_triangles.push_back(local[triangle[k]]);
+      growth.centroid_sum[k] += centroids[t * 3 + k];
+      growth.normal_sum[k] += normals[t * 3 + k];
+    }
+
+    ++growth.meshlet.triangle_count;
+    placed[t] = 1;
+    remove_triangle(adjacency, triangle, t);
+    remove_from_tree(tree, t);
+  }
+
+  if(growth.meshlet.triangle_count > 0) {
+    finish_meshlet(meshlets, growth, meshlet_vertices, local);
+  }
+
+  return meshlets.size() - first_meshlet;
+}
+
+static float distance(const float * a, const float * b)
+{
+  const float d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+
+  return sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+}
+
+// Ritter's sphere: the most distant pair of extreme points along an axis,
+// grown to take in the points left outside.
+static void compute_sphere(MeshletBounds & bounds, const unsigned int * vertices, size_t vertex_count, const float * positions,
+                           size_t position_stride)
+{
+  const float * minimum[3];
+  const float * maximum[3];
+
+  for(int k = 0; k < 3; ++k) {
+    minimum[k] = maximum[k] = &positions[vertices[0] * position_stride];
+  }
+
+  for(size_t i = 1; i < vertex_count; ++i) {
+    const float * position = &positions[vertices[i] * position_stride];
+
+    for(int k = 0; k < 3; ++k) {
+      minimum[k] = position[k] < minimum[k][k] ? position : minimum[k];
+      maximum[k] = position[k] > maximum[k][k] ? position : maximum[k];
+    }
+  }
+
+  int widest = 0;
+
+  for(int k = 1; k < 3; ++k) {
+    if(distance(minimum[k], maximum[k]) > distance(minimum[widest], maximum[widest])) {
+      widest = k;
+    }
+  }
+
+  for(int k = 0; k < 3; ++k) {
+    bounds.center[k] = (minimum[widest][k] + maximum[widest][k]) * 0.5f;
+  }
+
+  bounds.radius = distance(minimum[widest], maximum[widest]) * 0.5f;
+
+  for(size_t i = 0; i < vertex_count; ++i) {
+    const float * position = &positions[vertices[i] * position_stride];
+    const float d = distance(position, bounds.center);
+
+    if(d > bounds.radius) {
+      const float radius = (bounds.radius + d) * 0.5f;
+
+      for(int k = 0; k < 3; ++k) {
+        bounds.center[k] += (position[k] - bounds.center[k]) * (radius - bounds.radius) / d;
+      }
+
+      bounds.radius = radius;
+    }
+  }
+}
+
+// The axis is the normalised sum of the triangles' normals and the cutoff the
+// sine of the widest angle between a normal and the axis. The apex sits on
+// the axis behind every triangle's plane, so that a camera seeing the apex
+// from behind within the cone sees every triangle from behind too.
+MeshletBounds compute_meshlet_bounds(const Meshlet & meshlet, const unsigned int * meshlet_vertices,
+                                     const unsigned char * meshlet_triangles, const float * positions,
+                                     size_t position_stride)
+{
+  MeshletBounds bounds;
+  std::fill(bounds.center, bounds.center + 3, 0.f);
+  std::fill(bounds.cone_apex, bounds.cone_apex + 3, 0.f);
+  std::fill(bounds.cone_axis, bounds.cone_axis + 3, 0.f);
+  bounds.radius = 0.f;
+  bounds.cone_cutoff = 1.f;
+
+  if(meshlet.vertex_count == 0) {
+    return bounds;
+  }
+
+  const unsigned int * vertices = &meshlet_vertices[meshlet.vertex_offset];
+  const unsigned char * triangles = &meshlet_triangles[meshlet.triangle_offset * 3];
+
+  compute_sphere(bounds, vertices, meshlet.vertex_count, positions, position_stride);
+
+  std::vector<float> normals(meshlet.triangle_count * 3);
+  float axis[3] = { 0.f, 0.f, 0.f };
+
+  for(unsigned int t = 0; t < meshlet.triangle_count; ++t) {
+    triangle_normal(&normals[t * 3], &positions[vertices[triangles[t * 3]] * position_stride],
+                    &positions[vertices[triangles[t * 3 + 1]] * position_stride],
+                    &positions[vertices[triangles[t * 3 + 2]] * position_stride]);
+
+    for(int k = 0; k < 3; ++k) {
+      axis[k] += normals[t * 3 + k];
+    }
+  }
+
+  normalize(axis);
+
+  float min_dot = 1.f;
+  bool has_area = false;
+
+  for(unsigned int t = 0; t < meshlet.triangle_count; ++t) {
+    const float * normal = &normals[t * 3];
+
+    if(normal[0] != 0 || normal[1] != 0 || normal[2] != 0) {
+      min_dot = std::min(min_dot, normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2]);
+      has_area = true;
+    }
+  }
+
+  if(!has_area || min_dot <= MESHLET_MIN_CONE_DOT) {
+    return bounds;
+  }
+
+  float apex_distance = 0.f;
+
+  for(unsigned int t = 0; t < meshlet.triangle_count; ++t) {
+    const float * normal = &normals[t * 3];
+    const float * corner = &positions[vertices[triangles[t * 3]] * position_stride];
+    const float dot = normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2];
+
+    if(dot > 0) {
+      const float height = (bounds.center[0] - corner[0]) * normal[0] + (bounds.center[1] - corner[1]) * normal[1] +
+                           (bounds.center[2] - corner[2]) * normal[2];
+      apex_distance = std::max(apex_distance, height / dot);
+    }
+  }
+
+  for(int k = 0; k < 3; ++k) {
+    bounds.cone_apex[k] = bounds.center[k] - axis[k] * apex_distance;
+    bounds.cone_axis[k] = axis[k];
+  }
+
+  bounds.cone_cutoff = sqrtf(1.f - min_dot * min_dot);
+
+  return bounds;
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXMESHLET_H_
+#define FBX2JSON_FBXMESHLET_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace Fbx2Json
+{
+
+// Meshlet size limits suited to mesh shaders: 124 triangles keep the
+// primitive indices of a meshlet a multiple of four bytes long.
+const size_t MAX_MESHLET_VERTICES = 64;
+const size_t MAX_MESHLET_TRIANGLES = 124;
+
+// A small cluster of a mesh's triangles. Its `vertex_count` vertices are the
+// entries of the meshlet vertex table from `vertex_offset` on, holding mesh
+// vertex indices. Its `triangle_count` triangles start at triangle
+// `triangle_offset` of the meshlet triangle table, three bytes each, which
+// index the meshlet's vertices.
+struct Meshlet {
+  unsigned int vertex_offset;
+  unsigned int vertex_count;
+  unsigned int triangle_offset;
+  unsigned int triangle_count;
+};
+
+// Culling data for a meshlet. The sphere holds all of its vertices. The cone
+// holds its triangles' normals, so that none of them faces a camera at C when
+// dot(normalize(cone_apex - C), cone_axis) >= cone_cutoff. Meshlets whose
+// normals spread too far for that to help get a zero axis and a cutoff of 1.
+struct MeshletBounds {
+  float center[3];
+  float radius;
+  float cone_apex[3];
+  float cone_axis[3];
+  float cone_cutoff;
+};
+
+// Cuts a triangle list into meshlets of at most `max_vertices` (up to 255)
+// vertices and `max_triangles` triangles, appending them to the three tables.
+// Each meshlet grows from a seed by the adjacent triangle adding the fewest
+// vertices and, among those, lying closest to the meshlet and closest to its
+// average normal. Once no triangle is adjacent, the meshlet carries on with
+// the unused triangle whose centroid lies nearest its own, found with a k-d
+// tree over the triangles' centroids. Triangles repeating a vertex are left
+// out.
+//
+// `positions` holds three floats per vertex, `position_stride` floats apart.
+// Returns the number of meshlets added.
+size_t build_meshlets(std::vector<Meshlet> & meshlets, std::vector<unsigned int> & meshlet_vertices,
+                      std::vector<unsigned char> & meshlet_triangles, const unsigned int * indices, size_t index_count,
+                      const float * positions, size_t vertex_count, size_t position_stride,
+                      size_t max_vertices, size_t max_triangles);
+
+// Bounding sphere and normal cone of a meshlet built by build_meshlets from
+// the same positions.
+MeshletBounds compute_meshlet_bounds(const Meshlet & meshlet, const unsigned int * meshlet_vertices,
+                                     const unsigned char * meshlet_triangles, const float * positions,
+                                     size_t position_stride);
+
+} // namespace Fbx2Json
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXOPTIONS_H_
+#define FBX2JSON_FBXOPTIONS_H_
+
+#include <string>
+#include <vector>
+
+namespace Fbx2Json
+{
+
+// Conversion settings shared by the parser and the exporters.
+struct Options {
+  enum Format {
+    FORMAT_JSON,
+    FORMAT_BINARY,
+    FORMAT_GLB,
+  };
+
+  Options() : format(FORMAT_JSON), position_precision(-1), normal_precision(-1), uv_precision(-1),
+    quantize_normal_bits(0), compress(false), interleave(false), vertex_alignment(4), thread_count(0), gzip_level(0),
+    short_indices(true), split_meshes(false), optimize_vertex_cache(true), overdraw_threshold(0.f),
+    generate_tangents(true), build_meshlets(false), build_bvh(false), print_report(false) {}
+
+  // FORMAT_BINARY writes a JSON descriptor plus a .bin file holding the raw
+  // little-endian attribute and index arrays, FORMAT_GLB a binary glTF 2.0.
+  Format format;
+
+  // Fractional digits written for each attribute in JSON output, or -1 for
+  // the shortest text that reads back as the same float32.
+  int position_precision;
+  int normal_precision;
+  int uv_precision;
+
+  // When non-zero, FORMAT_BINARY writes the compact vertex layout described
+  // in fbx_quantize.h with normals packed into 8 or 16 bit components.
+  int quantize_normal_bits;
+
+  // FORMAT_BINARY only: store each array of the .bin file encoded with the
+  // lossless codecs in fbx_codec.h.
+  bool compress;
+
+  // FORMAT_BINARY only: store each mesh's vertex attributes interleaved in
+  // one buffer, those named in `interleave_order` first, with vertices
+  // padded to a multiple of `vertex_alignment` bytes (a power of two, at
+  // least 4). See fbx_interleave.h.
+  bool interleave;
+  std::vector<std::string> interleave_order;
+  int vertex_alignment;
+
+  // Threads used to read and serialise meshes, 0 for one per CPU. The output
+  // does not depend on it.
+  int thread_count;
+
+  // zlib compression level (1-9) for gzip-compressed output files, 0 to
+  // write them uncompressed.
+  int gzip_level;
+
+  // Store the indices of meshes of up to 65535 vertices as 16-bit values.
+  bool short_indices;
+
+  // Cut meshes with more vertices than that into parts that fit.
+  bool split_meshes;
+
+  // Reorder triangles and vertices for the GPU's vertex cache; see
+  // fbx_vertex_cache.h.
+  bool optimize_vertex_cache;
+
+  // When non-zero, also reorder triangles to reduce overdraw, accepting up
+  // to this factor of extra vertex cache misses (at least 1).
+  float overdraw_threshold;
+
+  // Compute tangents for meshes with normals and uvs but none in the file.
+  bool generate_tangents;
+
+  // Levels of detail added to each mesh, finest first: level i keeps
+  // lod_ratios[i] of the triangles (0 when missing, for as few as possible)
+  // without straying further than lod_errors[i] times the mesh's size (no
+  // limit when missing). The chain ends early once a level removes nothing.
+  std::vector<float> lod_ratios;
+  std::vector<float> lod_errors;
+
+  // FORMAT_BINARY only: cut each submesh into meshlets with culling bounds,
+  // see fbx_meshlet.h.
+  bool build_meshlets;
+
+  // FORMAT_BINARY only: add a bounding volume hierarchy over each mesh's
+  // triangles for picking and raycasts, see fbx_bvh_query.h.
+  bool build_bvh;
+
+  // Print per-mesh statistics to stdout once the output is written.
+  bool print_report;
+};
+
+} // namespace Fbx2Json
+
+#endif
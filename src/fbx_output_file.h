@@ -0,0 +1,54 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXOUTPUTFILE_H_
+#define FBX2JSON_FBXOUTPUTFILE_H_
+
+#include <string>
+#include "fbx_gzip_sink.h"
+#include "fbx_options.h"
+#include "fbx_sink.h"
+
+namespace Fbx2Json
+{
+
+// A file written by one of the exporters, gzip-compressed on the way out when
+// the options ask for it.
+class OutputFile : public Sink
+{
+  public:
+    OutputFile(const std::string path, const Options & options);
+    ~OutputFile();
+    bool is_open() const {
+      return file.is_open();
+    }
+    bool write(const char * data, size_t size);
+    bool close();
+
+  private:
+    FileSink file;
+    GzipSink * gzip;
+};
+
+} // namespace Fbx2Json
+
+#endif
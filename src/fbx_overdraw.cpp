@@ -0,0 +1,207 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "fbx_overdraw.h"
+#include "fbx_vertex_cache.h"
+
+namespace Fbx2Json
+{
+
+// FIFO cache simulated with timestamps: a vertex is cached while fewer than
+// VERTEX_CACHE_SIZE misses happened since it was loaded. Advancing the clock
+// by more than that flushes the cache.
+class CacheSimulation
+{
+  public:
+    CacheSimulation(size_t vertex_count) : timestamps(vertex_count, 0), clock(VERTEX_CACHE_SIZE + 1) {}
+
+    unsigned int add_triangle(const unsigned int * triangle) {
+      unsigned int misses = 0;
+
+      for(int k = 0; k < 3; ++k) {
+        if(clock - timestamps[triangle[k]] > VERTEX_CACHE_SIZE) {
+          timestamps[triangle[k]] = clock++;
+          ++misses;
+        }
+      }
+
+      return misses;
+    }
+
+    void flush() {
+      clock += VERTEX_CACHE_SIZE + 1;
+    }
+
+  private:
+    std::vector<size_t> timestamps;
+    size_t clock;
+};
+
+struct Cluster {
+  size_t first_triangle;
+  size_t triangle_count;
+  float sort_key;
+
+  static bool draw_first(const Cluster & a, const Cluster & b) {
+    return a.sort_key > b.sort_key;
+  }
+};
+
+// A triangle missing all three vertices usually starts a new patch of the
+// mesh, unconnected to what came before.
+static void find_patches(std::vector<size_t> & starts, const unsigned int * indices, size_t triangle_count, size_t vertex_count)
+{
+  CacheSimulation cache(vertex_count);
+
+  for(size_t t = 0; t < triangle_count; ++t) {
+    if(cache.add_triangle(&indices[t * 3]) == 3 || t == 0) {
+      starts.push_back(t);
+    }
+  }
+}
+
+// Cuts each patch as soon as the triangles since the last cut reach the
+// patch's own ACMR times the threshold, flushing the cache at every cut
+// since the clusters are about to be shuffled.
+static void find_clusters(std::vector<Cluster> & clusters, const std::vector<size_t> & patches, const unsigned int * indices,
+                          size_t triangle_count, size_t vertex_count, float threshold)
+{
+  CacheSimulation cache(vertex_count);
+
+  for(size_t p = 0; p < patches.size(); ++p) {
+    const size_t start = patches[p];
+    const size_t end = p + 1 < patches.size() ? patches[p + 1] : triangle_count;
+    unsigned int patch_misses = 0;
+
+    cache.flush();
+
+    for(size_t t = start; t < end; ++t) {
+      patch_misses += cache.add_triangle(&indices[t * 3]);
+    }
+
+    const float patch_threshold = threshold * patch_misses / (end - start);
+    Cluster cluster;
+    unsigned int misses = 0;
+
+    cluster.first_triangle = start;
+    cluster.sort_key = 0.f;
+    cache.flush();
+
+    for(size_t t = start; t < end; ++t) {
+      misses += cache.add_triangle(&indices[t * 3]);
+
+      if(static_cast<float>(misses) / (t + 1 - cluster.first_triangle) <= patch_threshold || t + 1 == end) {
+        cluster.triangle_count = t + 1 - cluster.first_triangle;
+        clusters.push_back(cluster);
+
+        cluster.first_triangle = t + 1;
+        misses = 0;
+        cache.flush();
+      }
+    }
+  }
+}
+
+// Sort key: how far the area-weighted cluster centroid lies from the mesh
+// centroid along the cluster's average normal.
+static void compute_sort_keys(std::vector<Cluster> & clusters, const unsigned int * indices, size_t index_count,
+                              const float * positions, size_t position_stride)
+{
+  double mesh_centroid[3] = { 0, 0, 0 };
+
+  for(size_t i = 0; i < index_count; ++i) {
+    const float * position = &positions[indices[i] * position_stride];
+
+    for(int k = 0; k < 3; ++k) {
+      mesh_centroid[k] += position[k];
+    }
+  }
+
+  for(int k = 0; k < 3; ++k) {
+    mesh_centroid[k] /= index_count;
+  }
+
+  for(std::vector<Cluster>::iterator cluster = clusters.begin(); cluster != clusters.end(); ++cluster) {
+    double centroid[3] = { 0, 0, 0 };
+    double normal[3] = { 0, 0, 0 };
+    double area = 0;
+
+    for(size_t t = cluster->first_triangle; t < cluster->first_triangle + cluster->triangle_count; ++t) {
+      const float * a = &positions[indices[t * 3] * position_stride];
+      const float * b = &positions[indices[t * 3 + 1] * position_stride];
+      const float * c = &positions[indices[t * 3 + 2] * position_stride];
+      const double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+      const double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+      const double cross[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+      const double triangle_area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+      // The cross product's length is twice the area, which cancels out.
+      for(int k = 0; k < 3; ++k) {
+        centroid[k] += (a[k] + b[k] + c[k]) / 3.0 * triangle_area;
+        normal[k] += cross[k];
+      }
+
+      area += triangle_area;
+    }
+
+    const double normal_length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    double key = 0;
+
+    if(area > 0 && normal_length > 0) {
+      for(int k = 0; k < 3; ++k) {
+        key += (centroid[k] / area - mesh_centroid[k]) * normal[k] / normal_length;
+      }
+    }
+
+    cluster->sort_key = static_cast<float>(key);
+  }
+}
+
+void optimize_overdraw(unsigned int * destination, const unsigned int * indices, size_t index_count,
+                       const float * positions, size_t vertex_count, size_t position_stride, float threshold)
+{
+  const size_t triangle_count = index_count / 3;
+
+  if(triangle_count == 0) {
+    return;
+  }
+
+  std::vector<size_t> patches;
+  std::vector<Cluster> clusters;
+
+  find_patches(patches, indices, triangle_count, vertex_count);
+  find_clusters(clusters, patches, indices, triangle_count, vertex_count, threshold);
+  compute_sort_keys(clusters, indices, triangle_count * 3, positions, position_stride);
+
+  // A stable sort keeps the output independent of the standard library.
+  std::stable_sort(clusters.begin(), clusters.end(), Cluster::draw_first);
+
+  for(std::vector<Cluster>::const_iterator cluster = clusters.begin(); cluster != clusters.end(); ++cluster) {
+    const unsigned int * first = &indices[cluster->first_triangle * 3];
+    destination = std::copy(first, first + cluster->triangle_count * 3, destination);
+  }
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXOVERDRAW_H_
+#define FBX2JSON_FBXOVERDRAW_H_
+
+#include <cstddef>
+
+namespace Fbx2Json
+{
+
+// Reorders a cache-optimised triangle list to reduce overdraw, after Sander,
+// Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw". Triangles are cut into clusters, each no more than
+// `threshold` times the ACMR of the patch it comes from (1.05 allows 5%
+// more cache misses), and clusters facing away from the mesh centre are
+// drawn first since they tend to occlude the rest from any view direction.
+//
+// `positions` holds three floats per vertex, `position_stride` floats apart.
+// `destination` receives `index_count` indices and must not alias `indices`.
+void optimize_overdraw(unsigned int * destination, const unsigned int * indices, size_t index_count,
+                       const float * positions, size_t vertex_count, size_t position_stride, float threshold);
+
+} // namespace Fbx2Json
+
+#endif
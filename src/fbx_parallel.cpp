@@ -0,0 +1,102 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <fbxsdk.h>
+#include "fbx_parallel.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Fbx2Json
+{
+
+struct ParallelJob {
+  size_t count;
+  ParallelTask task;
+  void * context;
+  volatile FbxAtomic next;
+};
+
+static void run_parallel_job(void * argument)
+{
+  ParallelJob * job = static_cast<ParallelJob *>(argument);
+
+  for(;;) {
+    const size_t index = static_cast<size_t>(FbxAtomOp::FetchAndInc(&job->next));
+
+    if(index >= job->count) {
+      break;
+    }
+
+    job->task(index, job->context);
+  }
+}
+
+int hardware_thread_count()
+{
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  const long count = info.dwNumberOfProcessors;
+#else
+  const long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+  return count > 0 ? static_cast<int>(count) : 1;
+}
+
+void parallel_for(size_t count, ParallelTask task, void * context, int thread_count)
+{
+  if(thread_count <= 1 || count <= 1) {
+    for(size_t i = 0; i < count; ++i) {
+      task(i, context);
+    }
+
+    return;
+  }
+
+  ParallelJob job;
+  job.count = count;
+  job.task = task;
+  job.context = context;
+  job.next = 0;
+
+  const size_t helper_count = (static_cast<size_t>(thread_count) < count ? thread_count : count) - 1;
+  std::vector<FbxThread *> helpers;
+
+  for(size_t i = 0; i < helper_count; ++i) {
+    helpers.push_back(new FbxThread(run_parallel_job, &job));
+  }
+
+  run_parallel_job(&job);
+
+  for(std::vector<FbxThread *>::iterator helper = helpers.begin(); helper != helpers.end(); ++helper) {
+    (*helper)->Join();
+    delete *helper;
+  }
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXPARALLEL_H_
+#define FBX2JSON_FBXPARALLEL_H_
+
+#include <cstddef>
+
+namespace Fbx2Json
+{
+
+typedef void (*ParallelTask)(size_t index, void * context);
+
+// Number of threads to use when the user has not asked for a specific count.
+int hardware_thread_count();
+
+// Calls task(index, context) for every index in [0, count) using up to
+// `thread_count` threads, the calling thread included, and returns once all
+// of them are done. Indices are handed out one at a time so uneven tasks
+// balance out. With a single thread everything runs in order on the caller.
+void parallel_for(size_t count, ParallelTask task, void * context, int thread_count);
+
+} // namespace Fbx2Json
+
+#endif
@@ -20,6 +20,9 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cfloat>
+#include "fbx_parallel.h"
 #include "fbx_parser.h"
 
 namespace Fbx2Json
@@ -30,6 +33,11 @@ Parser::Parser()
 
 }
 
+Parser::Parser(const Options & options) : options(options)
+{
+
+}
+
 // TODO: Capture scene texture filenames, convert to web-safe format
 // TODO: Materials
 void Parser::parse(FbxScene * scene)
@@ -38,11 +46,76 @@ void Parser::parse(FbxScene * scene)
   FbxAnimLayer * animation_layer = NULL;
 
   FbxNode * node = scene->GetRootNode();
+  const int threads = options.thread_count > 0 ? options.thread_count : hardware_thread_count();
+  MeshJobs jobs;
+
+  collect_meshes_recursive(node, animation_layer, jobs);
+  extract_meshes(jobs, animation_layer);
+
+  for(std::vector<MeshJob>::iterator job = jobs.jobs.begin(); job != jobs.jobs.end(); ++job) {
+    if(!job->extracted) {
+      delete job->mesh_cache;
+      continue;
+    }
+
+    finish_mesh(job->mesh_cache, job->report);
+  }
+
+  // The hierarchies only need the finished meshes.
+  if(options.build_bvh) {
+    parallel_for(meshes->size(), build_bvh_task, meshes, threads);
+  }
+}
 
-  bake_meshes_recursive(node, animation_layer);
+void Parser::build_bvh_task(size_t index, void * context)
+{
+  (*static_cast<std::vector<VBOMesh *> *>(context))[index]->build_bvh();
 }
 
-void Parser::bake_meshes_recursive(FbxNode * node, FbxAnimLayer * animation_layer)
+// Reading and triangulating a mesh leaves the scene untouched, so the meshes
+// collected since the last call are extracted in parallel. Deformations
+// evaluate the scene and read the control points themselves, so they then
+// run one mesh at a time, in scene order, before a later instance of the
+// same mesh moves its control points again.
+void Parser::extract_meshes(MeshJobs & jobs, FbxAnimLayer * animation_layer)
+{
+  const size_t count = jobs.jobs.size() - jobs.extracted;
+
+  if(count > 0) {
+    parallel_for(count, extract_mesh_task, &jobs.jobs[jobs.extracted],
+                 options.thread_count > 0 ? options.thread_count : hardware_thread_count());
+  }
+
+  for(std::vector<MeshJob>::iterator job = jobs.jobs.begin() + jobs.extracted; job != jobs.jobs.end(); ++job) {
+    if(job->extracted) {
+      FbxPose * pose = NULL;
+      FbxTime current_time;
+
+      bake_mesh_deformations(job->mesh, job->mesh_cache, current_time, animation_layer, job->global_offset_position, pose);
+    }
+  }
+
+  jobs.extracted = jobs.jobs.size();
+  jobs.pending.clear();
+}
+
+// Deformed meshes get their positions later, and may move corners apart that
+// coincide in the file.
+void Parser::extract_mesh_task(size_t index, void * context)
+{
+  MeshJob & job = static_cast<MeshJob *>(context)[index];
+
+  job.extracted = job.mesh_cache->initialize(job.mesh);
+
+  if(job.extracted) {
+    job.report.cleanup = job.mesh_cache->clean_up(!job.deformed);
+  }
+}
+
+// Moves control points to world space and lists the meshes to bake, in scene
+// order. A mesh shared by several nodes is moved again for each of them, so
+// the meshes waiting are extracted and deformed before that happens.
+void Parser::collect_meshes_recursive(FbxNode * node, FbxAnimLayer * animation_layer, MeshJobs & jobs)
 {
   FbxPose * pose = NULL;
   FbxTime current_time;
@@ -59,17 +132,23 @@ void Parser::bake_meshes_recursive(FbxNode * node, FbxAnimLayer * animation_laye
       FbxAMatrix geometry_offset = get_geometry(node);
       FbxAMatrix global_offset_position = global_position * geometry_offset;
 
+      if(jobs.pending.count(mesh)) {
+        extract_meshes(jobs, animation_layer);
+      }
+
       FbxVector4* control_points = mesh->GetControlPoints();
       bake_global_positions(control_points, mesh->GetControlPointsCount(), global_offset_position);
 
       if(mesh && !mesh->GetUserDataPtr()) {
-        VBOMesh * mesh_cache = new VBOMesh;
-
-        if(mesh_cache->initialize(mesh)) {
-          bake_mesh_deformations(mesh, mesh_cache, current_time, animation_layer, global_offset_position, pose);
-
-          meshes->push_back(mesh_cache);
-        }
+        MeshJob job;
+        job.mesh = mesh;
+        job.mesh_cache = new VBOMesh;
+        job.mesh_cache->name = node->GetName();
+        job.global_offset_position = global_offset_position;
+        job.deformed = mesh->GetShapeCount() > 0 || mesh->GetDeformerCount(FbxDeformer::eSkin) > 0;
+        job.extracted = false;
+        jobs.jobs.push_back(job);
+        jobs.pending.insert(mesh);
       }
     }
   }
@@ -77,7 +156,7 @@ void Parser::bake_meshes_recursive(FbxNode * node, FbxAnimLayer * animation_laye
   const int node_child_count = node->GetChildCount();
 
   for(int node_child_index = 0; node_child_index < node_child_count; ++node_child_index) {
-    bake_meshes_recursive(node->GetChild(node_child_index), animation_layer);
+    collect_meshes_recursive(node->GetChild(node_child_index), animation_layer, jobs);
   }
 }
     
@@ -133,12 +212,82 @@ void Parser::bake_mesh_deformations(FbxMesh* mesh, VBOMesh * mesh_cache, FbxTime
     }
 
     if(mesh_cache && vertex_array) {
-      mesh_cache->update_vertex_position(mesh, vertex_array);
+      mesh_cache->update_vertex_position(vertex_array);
     }
 
   delete [] vertex_array;
 }
 
+// Last steps once a mesh is fully baked. Meshes too large for 16-bit indices
+// are cut into parts when asked to, everything else gets 16-bit indices
+// where the mesh, or for the binary output each of its submeshes, fits.
+void Parser::finish_mesh(VBOMesh * mesh_cache, MeshReport & mesh_report)
+{
+  std::vector<VBOMesh *> parts;
+
+  if(options.generate_tangents) {
+    mesh_cache->generate_tangents(options.thread_count > 0 ? options.thread_count : hardware_thread_count());
+  }
+
+  mesh_report.name = mesh_cache->name;
+  mesh_report.triangle_count = mesh_cache->indices.size() / 3;
+  mesh_report.acmr_before = mesh_cache->get_acmr();
+
+  if(options.optimize_vertex_cache) {
+    mesh_cache->optimize_vertex_cache();
+  }
+
+  if(options.overdraw_threshold > 0) {
+    mesh_cache->optimize_overdraw(options.overdraw_threshold);
+  }
+
+  if(options.optimize_vertex_cache || options.overdraw_threshold > 0) {
+    mesh_cache->optimize_vertex_fetch();
+  }
+
+  mesh_report.vertex_count = mesh_cache->get_vertex_count();
+  mesh_report.acmr_after = mesh_cache->get_acmr();
+  report.add(mesh_report);
+
+  if(options.split_meshes && mesh_cache->get_vertex_count() > VBOMesh::MAX_SHORT_INDEX_VERTICES) {
+    mesh_cache->split(VBOMesh::MAX_SHORT_INDEX_VERTICES, parts);
+  }
+
+  if(parts.empty()) {
+    parts.push_back(mesh_cache);
+  } else {
+    delete mesh_cache;
+  }
+
+  const size_t lod_count = std::max(options.lod_ratios.size(), options.lod_errors.size());
+
+  for(std::vector<VBOMesh *>::iterator part = parts.begin(); part != parts.end(); ++part) {
+    (*part)->compute_submesh_bounds();
+
+    // Parts of a split mesh meet along their open borders, so these stay.
+    for(size_t level = 0; level < lod_count; ++level) {
+      const float ratio = level < options.lod_ratios.size() ? options.lod_ratios[level] : 0.f;
+      const float error = level < options.lod_errors.size() ? options.lod_errors[level] : FLT_MAX;
+
+      if(!(*part)->add_lod(ratio, error, parts.size() > 1, options.optimize_vertex_cache)) {
+        break;
+      }
+    }
+
+    if(options.build_meshlets) {
+      (*part)->build_meshlets();
+    }
+
+    // Only the binary output describes base vertices; glTF primitives share
+    // the mesh's vertex accessors and the hierarchy spans the whole mesh.
+    if(options.short_indices) {
+      (*part)->pack_indices(options.format == Options::FORMAT_BINARY && !options.build_bvh);
+    }
+
+    meshes->push_back(*part);
+  }
+}
+
 Parser::~Parser()
 {
 
@@ -23,10 +23,13 @@
 #ifndef FBX2JSON_FBXPARSER_H
 #define FBX2JSON_FBXPARSER_H
 
+#include <set>
 #include <vector>
 #include <fbxsdk.h>
 #include "fbx_deformation.h"
+#include "fbx_options.h"
 #include "fbx_position.h"
+#include "fbx_report.h"
 #include "fbx_vbomesh.h"
 
 namespace Fbx2Json
@@ -36,18 +39,47 @@ class Parser
 {
   public:
     Parser();
+    Parser(const Options & options);
     void parse(FbxScene* pScene);
     std::vector<VBOMesh *> * get_meshes() {
       return meshes;
     };
+    const Report & get_report() const {
+      return report;
+    }
     ~Parser();
 
   private:
-    void bake_meshes_recursive(FbxNode * node, FbxAnimLayer * animation_layer);
+    // A mesh of the scene on its way to becoming a VBOMesh.
+    struct MeshJob {
+      FbxMesh * mesh;
+      VBOMesh * mesh_cache;
+      FbxAMatrix global_offset_position;
+      MeshReport report;
+      bool deformed;
+      bool extracted;
+    };
+
+    // Meshes in scene order. Those from `extracted` on are waiting to be
+    // extracted, and `pending` holds their FbxMesh.
+    struct MeshJobs {
+      MeshJobs() : extracted(0) {}
+      std::vector<MeshJob> jobs;
+      size_t extracted;
+      std::set<const FbxMesh *> pending;
+    };
+
+    void collect_meshes_recursive(FbxNode * node, FbxAnimLayer * animation_layer, MeshJobs & jobs);
+    void extract_meshes(MeshJobs & jobs, FbxAnimLayer * animation_layer);
+    static void extract_mesh_task(size_t index, void * context);
     void bake_mesh_deformations(FbxMesh* mesh, VBOMesh * mesh_cache, FbxTime& time, FbxAnimLayer* animation_layer, FbxAMatrix& global_offset_position, FbxPose* pose);
     void bake_global_positions(FbxVector4* control_points, int control_points_count, FbxAMatrix& global_offset_position);
     void read_vertex_cache_data(FbxMesh* mesh, FbxTime& time, FbxVector4* vertex_array);
+    void finish_mesh(VBOMesh * mesh_cache, MeshReport & mesh_report);
+    static void build_bvh_task(size_t index, void * context);
 
+    Options options;
+    Report report;
     std::vector<VBOMesh *> * meshes;
 };
 
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "fbx_quantize.h"
+
+namespace Fbx2Json
+{
+
+const int SNORM16_MAX = 32767;
+const int SNORM8_MAX = 127;
+const int UNORM16_MAX = 65535;
+
+QuantizedMesh::QuantizedMesh() : position_error(0), normal_bits(16), normal_error(0), uvs_quantized(false), uv_error(0)
+{
+  for(int i = 0; i < 3; ++i) {
+    position_offset[i] = 0;
+    position_scale[i] = 0;
+  }
+}
+
+void QuantizedMesh::get_vertex_streams(const VBOMesh & mesh, std::vector<MeshStream> & streams) const
+{
+  streams.push_back(MeshStream("vertices", MeshStream::SEMANTIC_POSITION, MeshStream::FORMAT_INT16, 3, 4,
+                               positions.size() / 4, positions.empty() ? NULL : &positions[0]));
+
+  if(normal_bits == 8) {
+    streams.push_back(MeshStream("normals", MeshStream::SEMANTIC_NORMAL, MeshStream::FORMAT_INT8, 2, 2,
+                                 normals8.size() / 2, normals8.empty() ? NULL : &normals8[0]));
+  } else {
+    streams.push_back(MeshStream("normals", MeshStream::SEMANTIC_NORMAL, MeshStream::FORMAT_INT16, 2, 2,
+                                 normals16.size() / 2, normals16.empty() ? NULL : &normals16[0]));
+  }
+
+  // Uv sets after the first, colours and tangents are passed through.
+  std::vector<MeshStream> original;
+  mesh.get_vertex_streams(original);
+
+  for(std::vector<MeshStream>::iterator stream = original.begin(); stream != original.end(); ++stream) {
+    if(stream->semantic == MeshStream::SEMANTIC_TEXCOORD && stream->set == 0 && uvs_quantized) {
+      streams.push_back(MeshStream("uvs", MeshStream::SEMANTIC_TEXCOORD, MeshStream::FORMAT_UINT16, 2, 2,
+                                   uvs.size() / 2, uvs.empty() ? NULL : &uvs[0]));
+    } else if(stream->semantic != MeshStream::SEMANTIC_POSITION && stream->semantic != MeshStream::SEMANTIC_NORMAL) {
+      streams.push_back(*stream);
+    }
+  }
+}
+
+static inline float sign_not_zero(const float value)
+{
+  return value >= 0.f ? 1.f : -1.f;
+}
+
+void encode_octahedral(const float * normal, float * encoded)
+{
+  const float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+
+  if(length == 0.f) {
+    encoded[0] = 0.f;
+    encoded[1] = 0.f;
+    return;
+  }
+
+  float x = normal[0] / length;
+  float y = normal[1] / length;
+
+  if(normal[2] < 0.f) {
+    const float folded_x = (1.f - std::fabs(y)) * sign_not_zero(x);
+    const float folded_y = (1.f - std::fabs(x)) * sign_not_zero(y);
+    x = folded_x;
+    y = folded_y;
+  }
+
+  encoded[0] = x;
+  encoded[1] = y;
+}
+
+void decode_octahedral(const float * encoded, float * normal)
+{
+  float x = encoded[0];
+  float y = encoded[1];
+  const float z = 1.f - std::fabs(x) - std::fabs(y);
+
+  if(z < 0.f) {
+    const float unfolded_x = (1.f - std::fabs(y)) * sign_not_zero(x);
+    const float unfolded_y = (1.f - std::fabs(x)) * sign_not_zero(y);
+    x = unfolded_x;
+    y = unfolded_y;
+  }
+
+  const float length = std::sqrt(x * x + y * y + z * z);
+  normal[0] = x / length;
+  normal[1] = y / length;
+  normal[2] = z / length;
+}
+
+static inline float clamp_unit(const float value)
+{
+  return std::max(-1.f, std::min(1.f, value));
+}
+
+static inline float angle_between(const float * a, const float * b)
+{
+  const float length_a = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+
+  if(length_a == 0.f) {
+    return 0.f;
+  }
+
+  const float cosine = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / length_a;
+  return std::acos(clamp_unit(cosine));
+}
+
+// Rounding each coordinate independently is not always the closest code on
+// the sphere, so the four neighbouring codes are tried.
+static void quantize_normal(const float * normal, const int max_value, int * code, float & error)
+{
+  float encoded[2];
+  encode_octahedral(normal, encoded);
+
+  const int base_x = static_cast<int>(std::floor(encoded[0] * max_value));
+  const int base_y = static_cast<int>(std::floor(encoded[1] * max_value));
+  error = 4.f;
+
+  for(int i = 0; i < 4; ++i) {
+    const int candidate_x = std::max(-max_value, std::min(max_value, base_x + (i & 1)));
+    const int candidate_y = std::max(-max_value, std::min(max_value, base_y + (i >> 1)));
+    const float candidate[2] = {
+      static_cast<float>(candidate_x) / max_value,
+      static_cast<float>(candidate_y) / max_value
+    };
+    float decoded[3];
+    decode_octahedral(candidate, decoded);
+
+    const float candidate_error = angle_between(normal, decoded);
+
+    if(candidate_error < error) {
+      error = candidate_error;
+      code[0] = candidate_x;
+      code[1] = candidate_y;
+    }
+  }
+}
+
+static void quantize_positions(const VBOMesh & mesh, QuantizedMesh & quantized)
+{
+  const size_t vertex_count = mesh.vertices.size() / 4;
+
+  if(vertex_count == 0) {
+    return;
+  }
+
+  float min[3];
+  float max[3];
+
+  for(int j = 0; j < 3; ++j) {
+    min[j] = max[j] = mesh.vertices[j];
+  }
+
+  for(size_t i = 0; i < vertex_count; ++i) {
+    for(int j = 0; j < 3; ++j) {
+      min[j] = std::min(min[j], mesh.vertices[i * 4 + j]);
+      max[j] = std::max(max[j], mesh.vertices[i * 4 + j]);
+    }
+  }
+
+  for(int j = 0; j < 3; ++j) {
+    quantized.position_offset[j] = (min[j] + max[j]) * 0.5f;
+    quantized.position_scale[j] = (max[j] - min[j]) * 0.5f;
+  }
+
+  quantized.positions.resize(vertex_count * 4);
+
+  for(size_t i = 0; i < vertex_count; ++i) {
+    float error = 0;
+
+    for(int j = 0; j < 3; ++j) {
+      const float scale = quantized.position_scale[j];
+      const float value = mesh.vertices[i * 4 + j];
+      int code = 0;
+
+      if(scale > 0.f) {
+        const float normalized = clamp_unit((value - quantized.position_offset[j]) / scale);
+        code = static_cast<int>(std::floor(normalized * SNORM16_MAX + 0.5f));
+      }
+
+      quantized.positions[i * 4 + j] = static_cast<int16_t>(code);
+
+      const float decoded = quantized.position_offset[j] + scale * code / SNORM16_MAX;
+      error += (decoded - value) * (decoded - value);
+    }
+
+    quantized.positions[i * 4 + 3] = SNORM16_MAX;
+    quantized.position_error = std::max(quantized.position_error, std::sqrt(error));
+  }
+}
+
+static void quantize_normals(const VBOMesh & mesh, QuantizedMesh & quantized)
+{
+  const size_t vertex_count = mesh.normals.size() / 3;
+  const int max_value = quantized.normal_bits == 8 ? SNORM8_MAX : SNORM16_MAX;
+
+  if(quantized.normal_bits == 8) {
+    quantized.normals8.resize(vertex_count * 2);
+  } else {
+    quantized.normals16.resize(vertex_count * 2);
+  }
+
+  for(size_t i = 0; i < vertex_count; ++i) {
+    int code[2] = { 0, 0 };
+    float error;
+    quantize_normal(&mesh.normals[i * 3], max_value, code, error);
+
+    if(quantized.normal_bits == 8) {
+      quantized.normals8[i * 2] = static_cast<int8_t>(code[0]);
+      quantized.normals8[i * 2 + 1] = static_cast<int8_t>(code[1]);
+    } else {
+      quantized.normals16[i * 2] = static_cast<int16_t>(code[0]);
+      quantized.normals16[i * 2 + 1] = static_cast<int16_t>(code[1]);
+    }
+
+    quantized.normal_error = std::max(quantized.normal_error, error);
+  }
+}
+
+static void quantize_uvs(const VBOMesh & mesh, QuantizedMesh & quantized)
+{
+  for(std::vector<float>::const_iterator uv = mesh.uvs.begin(); uv != mesh.uvs.end(); ++uv) {
+    if(!(*uv >= 0.f && *uv <= 1.f)) {
+      return;
+    }
+  }
+
+  quantized.uvs_quantized = true;
+  quantized.uvs.resize(mesh.uvs.size());
+
+  for(size_t i = 0; i < mesh.uvs.size(); ++i) {
+    const int code = static_cast<int>(std::floor(mesh.uvs[i] * UNORM16_MAX + 0.5f));
+    quantized.uvs[i] = static_cast<uint16_t>(code);
+    quantized.uv_error = std::max(quantized.uv_error, std::fabs(static_cast<float>(code) / UNORM16_MAX - mesh.uvs[i]));
+  }
+}
+
+void quantize_mesh(const VBOMesh & mesh, int normal_bits, QuantizedMesh & quantized)
+{
+  quantized.normal_bits = normal_bits == 8 ? 8 : 16;
+
+  quantize_positions(mesh, quantized);
+  quantize_normals(mesh, quantized);
+  quantize_uvs(mesh, quantized);
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXQUANTIZE_H_
+#define FBX2JSON_FBXQUANTIZE_H_
+
+#include <vector>
+#include <stdint.h>
+#include "fbx_vbomesh.h"
+
+namespace Fbx2Json
+{
+
+// Compact vertex layout for a VBOMesh:
+//  - positions as normalised int16 XYZW relative to the mesh bounding box,
+//    decoded with offset + scale * q / 32767 (W is always 32767)
+//  - normals as octahedral-encoded snorm8 or snorm16 pairs
+//  - uvs as unorm16 pairs when all of them fall inside [0, 1], otherwise
+//    left as floats (uvs_quantized is false)
+// Each *_error is the largest difference measured between an original and a
+// decoded value: distance for positions, angle in radians for normals and
+// per-component difference for uvs.
+struct QuantizedMesh {
+  QuantizedMesh();
+
+  // Same streams as VBOMesh::get_vertex_streams, in the compact layout.
+  // Unquantized uvs are taken from `mesh`.
+  void get_vertex_streams(const VBOMesh & mesh, std::vector<MeshStream> & streams) const;
+
+  std::vector<int16_t> positions;
+  float position_offset[3];
+  float position_scale[3];
+  float position_error;
+
+  int normal_bits;
+  std::vector<int8_t> normals8;
+  std::vector<int16_t> normals16;
+  float normal_error;
+
+  bool uvs_quantized;
+  std::vector<uint16_t> uvs;
+  float uv_error;
+};
+
+void quantize_mesh(const VBOMesh & mesh, int normal_bits, QuantizedMesh & quantized);
+
+// Octahedral mapping of a unit vector onto [-1, 1]^2 and back.
+void encode_octahedral(const float * normal, float * encoded);
+void decode_octahedral(const float * encoded, float * normal);
+
+} // namespace Fbx2Json
+
+#endif
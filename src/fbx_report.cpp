@@ -0,0 +1,84 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iomanip>
+#include "fbx_report.h"
+
+namespace Fbx2Json
+{
+
+void Report::add(const MeshReport & mesh)
+{
+  meshes.push_back(mesh);
+}
+
+static void print_row(std::ostream & stream, const MeshReport & mesh)
+{
+  stream << std::setw(8) << mesh.vertex_count << " " << std::setw(10) << mesh.triangle_count << "  ";
+  stream << std::fixed << std::setprecision(3) << std::setw(6) << mesh.acmr_before << " -> " << std::setw(6) << mesh.acmr_after;
+  stream << "  " << std::setw(10) << mesh.cleanup.degenerate_triangles << " " << std::setw(9) << mesh.cleanup.duplicate_triangles;
+  stream << " " << std::setw(6) << mesh.cleanup.unused_vertices << "  " << mesh.name << std::endl;
+}
+
+void Report::print(std::ostream & stream) const
+{
+  // Totals weigh each mesh's ACMR by its triangle count, which gives the
+  // ratio for the scene as a whole.
+  MeshReport total;
+  double misses_before = 0;
+  double misses_after = 0;
+
+  total.name = "total";
+
+  stream << "vertices  triangles  ACMR before/after  degenerate duplicate unused  mesh" << std::endl;
+
+  for(std::vector<MeshReport>::const_iterator mesh = meshes.begin(); mesh != meshes.end(); ++mesh) {
+    print_row(stream, *mesh);
+
+    total.vertex_count += mesh->vertex_count;
+    total.triangle_count += mesh->triangle_count;
+    total.cleanup.degenerate_triangles += mesh->cleanup.degenerate_triangles;
+    total.cleanup.duplicate_triangles += mesh->cleanup.duplicate_triangles;
+    total.cleanup.unused_vertices += mesh->cleanup.unused_vertices;
+    misses_before += static_cast<double>(mesh->acmr_before) * mesh->triangle_count;
+    misses_after += static_cast<double>(mesh->acmr_after) * mesh->triangle_count;
+  }
+
+  if(total.triangle_count > 0) {
+    total.acmr_before = static_cast<float>(misses_before / total.triangle_count);
+    total.acmr_after = static_cast<float>(misses_after / total.triangle_count);
+  }
+
+  print_row(stream, total);
+
+  // Shares of what the file held, the counts above being what was kept.
+  const size_t removed_triangles = total.cleanup.degenerate_triangles + total.cleanup.duplicate_triangles;
+
+  if(removed_triangles > 0 || total.cleanup.unused_vertices > 0) {
+    stream << "removed " << std::setprecision(1)
+           << 100.0 * removed_triangles / (total.triangle_count + removed_triangles) << "% of triangles and "
+           << 100.0 * total.cleanup.unused_vertices / (total.vertex_count + total.cleanup.unused_vertices)
+           << "% of vertices" << std::endl;
+  }
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXREPORT_H_
+#define FBX2JSON_FBXREPORT_H_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "fbx_cleanup.h"
+
+namespace Fbx2Json
+{
+
+// Statistics gathered while baking one mesh, before it is split.
+struct MeshReport {
+  MeshReport() : vertex_count(0), triangle_count(0), acmr_before(0.f), acmr_after(0.f) {}
+
+  std::string name;
+  size_t vertex_count;
+  size_t triangle_count;
+
+  // Average cache miss ratio before and after vertex cache optimisation;
+  // both hold the same value when the mesh was not optimised.
+  float acmr_before;
+  float acmr_after;
+
+  // What was removed before the counts above were taken.
+  CleanupResult cleanup;
+};
+
+// Summary of a conversion, printed by `fbx2json -r`.
+class Report
+{
+  public:
+    void add(const MeshReport & mesh);
+    void print(std::ostream & stream) const;
+
+  private:
+    std::vector<MeshReport> meshes;
+};
+
+} // namespace Fbx2Json
+
+#endif
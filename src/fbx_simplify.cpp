@@ -0,0 +1,1078 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * The simplifier is derived from simplifier.cpp of meshoptimizer
+ * (https://github.com/zeux/meshoptimizer), which carries this notice:
+ *
+ * Copyright (c) 2016-2024 Arseny Kapoulkine
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "fbx_simplify.h"
+
+namespace Fbx2Json
+{
+
+const unsigned int NO_VERTEX = ~0u;
+
+// Which way a vertex may move: anywhere, along its border, along its seam,
+// all its copies together or not at all.
+enum VertexKind {
+  KIND_MANIFOLD,
+  KIND_BORDER,
+  KIND_SEAM,
+  KIND_COMPLEX,
+  KIND_LOCKED,
+  KIND_COUNT
+};
+
+// Whether a vertex of the first kind may collapse onto one of the second.
+static const bool CAN_COLLAPSE[KIND_COUNT][KIND_COUNT] = {
+  { true, true, true, true, true },
+  { false, true, false, false, false },
+  { false, false, true, false, false },
+  { false, true, true, true, false },
+  { false, false, false, false, false },
+};
+
+// Whether an edge between vertices of the two kinds is shared by two
+// triangles, and so is seen once from each side (counting seam edges, whose
+// two sides use different copies of the vertices).
+static const bool HAS_OPPOSITE[KIND_COUNT][KIND_COUNT] = {
+  { true, true, true, false, true },
+  { true, false, true, false, false },
+  { true, true, true, false, true },
+  { false, false, false, false, false },
+  { true, false, true, false, false },
+};
+
+// Edge planes along borders weigh more than those along seams, where the
+// surface carries on past the edge.
+const float BORDER_EDGE_WEIGHT = 10.f;
+const float SEAM_EDGE_WEIGHT = 1.f;
+
+struct Vector3 {
+  float x, y, z;
+};
+
+// Weighted sum of squared distances to planes, as the terms of
+// p.A.p + 2 b.p + c, and the sum of the weights.
+struct Quadric {
+  float a00, a11, a22;
+  float a10, a20, a21;
+  float b0, b1, b2, c;
+  float w;
+};
+
+// Weighted gradient of one attribute across the triangles of a quadric,
+// evaluated as g.p + gw.
+struct QuadricGradient {
+  float gx, gy, gz, gw;
+};
+
+// Half-edges leaving each vertex, with the other two corners of the
+// triangle each one belongs to.
+struct EdgeAdjacency {
+  struct Edge {
+    unsigned int next;
+    unsigned int prev;
+  };
+
+  std::vector<unsigned int> counts;
+  std::vector<unsigned int> offsets;
+  std::vector<Edge> data;
+};
+
+// Moving v0 onto v1. `distance` is the squared geometric error alone,
+// `error` adds the attribute error and decides the order.
+struct Collapse {
+  unsigned int v0;
+  unsigned int v1;
+  bool bidirectional;
+  float error;
+  float distance;
+
+  static bool cheaper(const Collapse & a, const Collapse & b) {
+    return a.error < b.error;
+  }
+};
+
+static unsigned int hash_position(const float * position)
+{
+  unsigned int bits[3];
+  memcpy(bits, position, sizeof(bits));
+
+  unsigned int h = (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+
+  return h;
+}
+
+void build_position_remap(unsigned int * remap, const float * positions, size_t vertex_count, size_t position_stride)
+{
+  size_t table_size = 16;
+
+  while(table_size < vertex_count * 2) {
+    table_size *= 2;
+  }
+
+  std::vector<unsigned int> table(table_size, NO_VERTEX);
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    const float * position = &positions[v * position_stride];
+    size_t slot = hash_position(position) & (table_size - 1);
+
+    while(table[slot] != NO_VERTEX && memcmp(&positions[table[slot] * position_stride], position, 3 * sizeof(float)) != 0) {
+      slot = (slot + 1) & (table_size - 1);
+    }
+
+    if(table[slot] == NO_VERTEX) {
+      table[slot] = static_cast<unsigned int>(v);
+    }
+
+    remap[v] = table[slot];
+  }
+}
+
+float simplify_scale(const float * positions, size_t vertex_count, size_t position_stride)
+{
+  if(vertex_count == 0) {
+    return 0.f;
+  }
+
+  float min[3] = { positions[0], positions[1], positions[2] };
+  float max[3] = { positions[0], positions[1], positions[2] };
+
+  for(size_t v = 1; v < vertex_count; ++v) {
+    for(int k = 0; k < 3; ++k) {
+      min[k] = std::min(min[k], positions[v * position_stride + k]);
+      max[k] = std::max(max[k], positions[v * position_stride + k]);
+    }
+  }
+
+  return std::max(max[0] - min[0], std::max(max[1] - min[1], max[2] - min[2]));
+}
+
+// Positions moved into the unit cube, so errors are fractions of the scale.
+static void rescale_positions(std::vector<Vector3> & points, const float * positions, size_t vertex_count, size_t position_stride)
+{
+  const float scale = simplify_scale(positions, vertex_count, position_stride);
+  const float inverse = scale == 0.f ? 0.f : 1.f / scale;
+  float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    for(int k = 0; k < 3; ++k) {
+      min[k] = std::min(min[k], positions[v * position_stride + k]);
+    }
+  }
+
+  points.resize(vertex_count);
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    const float * position = &positions[v * position_stride];
+
+    points[v].x = (position[0] - min[0]) * inverse;
+    points[v].y = (position[1] - min[1]) * inverse;
+    points[v].z = (position[2] - min[2]) * inverse;
+  }
+}
+
+// Rebuilds the adjacency of a triangle list, with vertices welded through
+// `remap` when it is not NULL.
+static void update_edge_adjacency(EdgeAdjacency & adjacency, const unsigned int * indices, size_t index_count, size_t vertex_count,
+                                  const unsigned int * remap)
+{
+  adjacency.counts.assign(vertex_count, 0);
+  adjacency.offsets.resize(vertex_count);
+  adjacency.data.resize(index_count);
+
+  for(size_t i = 0; i < index_count; ++i) {
+    adjacency.counts[remap != NULL ? remap[indices[i]] : indices[i]] += 1;
+  }
+
+  unsigned int offset = 0;
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    adjacency.offsets[v] = offset;
+    offset += adjacency.counts[v];
+  }
+
+  // Used as write cursors, then moved back to the start of each list.
+  for(size_t i = 0; i < index_count; i += 3) {
+    unsigned int corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
+
+    if(remap != NULL) {
+      for(int k = 0; k < 3; ++k) {
+        corners[k] = remap[corners[k]];
+      }
+    }
+
+    for(int k = 0; k < 3; ++k) {
+      EdgeAdjacency::Edge & edge = adjacency.data[adjacency.offsets[corners[k]]++];
+      edge.next = corners[(k + 1) % 3];
+      edge.prev = corners[(k + 2) % 3];
+    }
+  }
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    adjacency.offsets[v] -= adjacency.counts[v];
+  }
+}
+
+static bool has_edge(const EdgeAdjacency & adjacency, unsigned int a, unsigned int b)
+{
+  const EdgeAdjacency::Edge * edges = &adjacency.data[0] + adjacency.offsets[a];
+
+  for(unsigned int i = 0; i < adjacency.counts[a]; ++i) {
+    if(edges[i].next == b) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Whether every edge around the position `r` is shared by exactly two
+// triangles once the copies of each vertex are welded.
+static bool is_welded_manifold(const EdgeAdjacency & welded, unsigned int r)
+{
+  const EdgeAdjacency::Edge * edges = welded.data.empty() ? NULL : &welded.data[0] + welded.offsets[r];
+
+  for(unsigned int i = 0; i < welded.counts[r]; ++i) {
+    const unsigned int target = edges[i].next;
+    unsigned int count = 0;
+
+    for(unsigned int j = 0; j < welded.counts[r]; ++j) {
+      count += edges[j].next == target;
+    }
+
+    if(target == r || count != 1 || !has_edge(welded, target, r)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// A half-edge is open when no triangle uses it the other way round. `loop`
+// and `loopback` receive the vertex each border or seam vertex's open edges
+// lead to and come from; a vertex with several open edges either way cannot
+// be moved safely and is locked. Vertices whose copies do not form a single
+// seam, such as the pole of a uv sphere, are complex when the surface around
+// them is closed and locked otherwise.
+static void classify_vertices(std::vector<unsigned char> & kinds, std::vector<unsigned int> & loop, std::vector<unsigned int> & loopback,
+                              const EdgeAdjacency & adjacency, const EdgeAdjacency & welded, const std::vector<unsigned int> & remap,
+                              const std::vector<unsigned int> & wedge, const unsigned char * vertex_lock, bool lock_border)
+{
+  const size_t vertex_count = remap.size();
+
+  loop.assign(vertex_count, NO_VERTEX);
+  loopback.assign(vertex_count, NO_VERTEX);
+  kinds.assign(vertex_count, KIND_LOCKED);
+
+  // Set to the vertex itself when there is more than one open edge.
+  std::vector<unsigned int> & open_out = loop;
+  std::vector<unsigned int> & open_in = loopback;
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    const unsigned int vertex = static_cast<unsigned int>(v);
+    const EdgeAdjacency::Edge * edges = adjacency.data.empty() ? NULL : &adjacency.data[0] + adjacency.offsets[v];
+
+    for(unsigned int i = 0; i < adjacency.counts[v]; ++i) {
+      const unsigned int target = edges[i].next;
+
+      // A degenerate triangle's self edge would close an open edge of a
+      // real one, so treat it as making the vertex complex instead.
+      if(target == vertex) {
+        open_in[vertex] = open_out[vertex] = vertex;
+      } else if(!has_edge(adjacency, target, vertex)) {
+        open_in[target] = open_in[target] == NO_VERTEX ? vertex : target;
+        open_out[vertex] = open_out[vertex] == NO_VERTEX ? target : vertex;
+      }
+    }
+  }
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    if(remap[v] != v) {
+      continue;
+    }
+
+    const unsigned int i = static_cast<unsigned int>(v);
+
+    if(wedge[i] == i) {
+      // Open edges that close up once welded run along another vertex's
+      // seam, which this one does not need to follow.
+      if((open_in[i] == NO_VERTEX && open_out[i] == NO_VERTEX) || is_welded_manifold(welded, i)) {
+        kinds[i] = KIND_MANIFOLD;
+      } else if(open_in[i] != i && open_out[i] != i) {
+        kinds[i] = lock_border ? KIND_LOCKED : KIND_BORDER;
+      }
+    } else if(wedge[wedge[i]] == i) {
+      // Both copies need exactly one open edge each way, running along the
+      // same pair of positions in opposite directions.
+      const unsigned int w = wedge[i];
+
+      if(open_in[i] != NO_VERTEX && open_in[i] != i && open_out[i] != NO_VERTEX && open_out[i] != i &&
+         open_in[w] != NO_VERTEX && open_in[w] != w && open_out[w] != NO_VERTEX && open_out[w] != w &&
+         remap[open_in[i]] == remap[open_out[w]] && remap[open_out[i]] == remap[open_in[w]] &&
+         remap[open_in[i]] != remap[open_out[i]]) {
+        kinds[i] = KIND_SEAM;
+      }
+    }
+
+    if(wedge[i] != i && kinds[i] == KIND_LOCKED && is_welded_manifold(welded, i)) {
+      kinds[i] = KIND_COMPLEX;
+    }
+  }
+
+  if(vertex_lock != NULL) {
+    for(size_t v = 0; v < vertex_count; ++v) {
+      if(vertex_lock[v]) {
+        kinds[remap[v]] = KIND_LOCKED;
+      }
+    }
+  }
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    kinds[v] = kinds[remap[v]];
+  }
+}
+
+static void quadric_add(Quadric & q, const Quadric & r)
+{
+  q.a00 += r.a00;
+  q.a11 += r.a11;
+  q.a22 += r.a22;
+  q.a10 += r.a10;
+  q.a20 += r.a20;
+  q.a21 += r.a21;
+  q.b0 += r.b0;
+  q.b1 += r.b1;
+  q.b2 += r.b2;
+  q.c += r.c;
+  q.w += r.w;
+}
+
+static void quadric_add(QuadricGradient * g, const QuadricGradient * r, size_t attribute_count)
+{
+  for(size_t k = 0; k < attribute_count; ++k) {
+    g[k].gx += r[k].gx;
+    g[k].gy += r[k].gy;
+    g[k].gz += r[k].gz;
+    g[k].gw += r[k].gw;
+  }
+}
+
+// The plane a.x + b.y + c.z + d = 0, with a unit normal.
+static void quadric_from_plane(Quadric & q, float a, float b, float c, float d, float w)
+{
+  q.a00 = a * a * w;
+  q.a11 = b * b * w;
+  q.a22 = c * c * w;
+  q.a10 = a * b * w;
+  q.a20 = a * c * w;
+  q.a21 = b * c * w;
+  q.b0 = a * d * w;
+  q.b1 = b * d * w;
+  q.b2 = c * d * w;
+  q.c = d * d * w;
+  q.w = w;
+}
+
+static float normalize(Vector3 & v)
+{
+  const float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+
+  if(length > 0.f) {
+    v.x /= length;
+    v.y /= length;
+    v.z /= length;
+  }
+
+  return length;
+}
+
+static Vector3 subtract(const Vector3 & a, const Vector3 & b)
+{
+  const Vector3 result = { a.x - b.x, a.y - b.y, a.z - b.z };
+  return result;
+}
+
+static Vector3 cross(const Vector3 & a, const Vector3 & b)
+{
+  const Vector3 result = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+  return result;
+}
+
+static float dot(const Vector3 & a, const Vector3 & b)
+{
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Weighted by the square root of the area, so that the weight grows with
+// the triangle's size like an edge's does with its length.
+static void quadric_from_triangle(Quadric & q, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float weight)
+{
+  Vector3 normal = cross(subtract(p1, p0), subtract(p2, p0));
+  const float area = normalize(normal);
+
+  quadric_from_plane(q, normal.x, normal.y, normal.z, -dot(normal, p0), sqrtf(area) * weight);
+}
+
+// The plane through the edge p0 p1 at right angles to the triangle, which
+// keeps border and seam vertices on their edge.
+static void quadric_from_triangle_edge(Quadric & q, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float weight)
+{
+  Vector3 edge = subtract(p1, p0);
+  const float length = normalize(edge);
+  const Vector3 p20 = subtract(p2, p0);
+  const float along = dot(p20, edge);
+  Vector3 normal = { p20.x - edge.x * along, p20.y - edge.y * along, p20.z - edge.z * along };
+  normalize(normal);
+
+  quadric_from_plane(q, normal.x, normal.y, normal.z, -dot(normal, p0), length * weight);
+}
+
+// Each attribute is interpolated linearly across the triangle as g.p + gw
+// and the quadric measures (g.p + gw - a)^2. The terms that do not depend on
+// the value a go into the quadric itself, the rest into the gradients.
+static void quadric_from_attributes(Quadric & q, QuadricGradient * g, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2,
+                                    const float * a0, const float * a1, const float * a2, size_t attribute_count)
+{
+  const Vector3 v0 = subtract(p1, p0);
+  const Vector3 v1 = subtract(p2, p0);
+  const Vector3 normal = cross(v0, v1);
+  const float w = sqrtf(sqrtf(dot(normal, normal)));
+
+  // Gradients of the barycentric coordinates of p1 and p2.
+  const float d00 = dot(v0, v0);
+  const float d01 = dot(v0, v1);
+  const float d11 = dot(v1, v1);
+  const float denominator = d00 * d11 - d01 * d01;
+  const float inverse = denominator == 0.f ? 0.f : 1.f / denominator;
+  const Vector3 g1 = { (d11 * v0.x - d01 * v1.x) * inverse, (d11 * v0.y - d01 * v1.y) * inverse, (d11 * v0.z - d01 * v1.z) * inverse };
+  const Vector3 g2 = { (d00 * v1.x - d01 * v0.x) * inverse, (d00 * v1.y - d01 * v0.y) * inverse, (d00 * v1.z - d01 * v0.z) * inverse };
+
+  memset(&q, 0, sizeof(q));
+  q.w = w;
+
+  for(size_t k = 0; k < attribute_count; ++k) {
+    const float gx = g1.x * (a1[k] - a0[k]) + g2.x * (a2[k] - a0[k]);
+    const float gy = g1.y * (a1[k] - a0[k]) + g2.y * (a2[k] - a0[k]);
+    const float gz = g1.z * (a1[k] - a0[k]) + g2.z * (a2[k] - a0[k]);
+    const float gw = a0[k] - p0.x * gx - p0.y * gy - p0.z * gz;
+
+    q.a00 += w * gx * gx;
+    q.a11 += w * gy * gy;
+    q.a22 += w * gz * gz;
+    q.a10 += w * gy * gx;
+    q.a20 += w * gz * gx;
+    q.a21 += w * gz * gy;
+    q.b0 += w * gx * gw;
+    q.b1 += w * gy * gw;
+    q.b2 += w * gz * gw;
+    q.c += w * gw * gw;
+
+    g[k].gx = w * gx;
+    g[k].gy = w * gy;
+    g[k].gz = w * gz;
+    g[k].gw = w * gw;
+  }
+}
+
+static float quadric_value(const Quadric & q, const Vector3 & v)
+{
+  float rx = q.b0 + q.a10 * v.y;
+  float ry = q.b1 + q.a21 * v.z;
+  float rz = q.b2 + q.a20 * v.x;
+
+  rx = rx * 2 + q.a00 * v.x;
+  ry = ry * 2 + q.a11 * v.y;
+  rz = rz * 2 + q.a22 * v.z;
+
+  return q.c + rx * v.x + ry * v.y + rz * v.z;
+}
+
+// Mean squared distance to the quadric's planes.
+static float quadric_error(const Quadric & q, const Vector3 & v)
+{
+  return q.w == 0.f ? 0.f : fabsf(quadric_value(q, v)) / q.w;
+}
+
+static float quadric_error(const Quadric & q, const QuadricGradient * g, size_t attribute_count, const Vector3 & v, const float * a)
+{
+  float r = quadric_value(q, v);
+
+  for(size_t k = 0; k < attribute_count; ++k) {
+    r += a[k] * a[k] * q.w - 2 * a[k] * (v.x * g[k].gx + v.y * g[k].gy + v.z * g[k].gz + g[k].gw);
+  }
+
+  return q.w == 0.f ? 0.f : fabsf(r) / q.w;
+}
+
+static void fill_face_quadrics(std::vector<Quadric> & quadrics, const unsigned int * indices, size_t index_count,
+                               const std::vector<Vector3> & points, const std::vector<unsigned int> & remap)
+{
+  for(size_t i = 0; i < index_count; i += 3) {
+    Quadric q;
+    quadric_from_triangle(q, points[indices[i]], points[indices[i + 1]], points[indices[i + 2]], 1.f);
+
+    for(int k = 0; k < 3; ++k) {
+      quadric_add(quadrics[remap[indices[i + k]]], q);
+    }
+  }
+}
+
+static bool on_loop(unsigned char kind)
+{
+  return kind == KIND_BORDER || kind == KIND_SEAM;
+}
+
+// Edges along borders and seams, including those ending at a locked vertex
+// so that the last border edge before a corner is weighed correctly too.
+static void fill_edge_quadrics(std::vector<Quadric> & quadrics, const unsigned int * indices, size_t index_count,
+                               const std::vector<Vector3> & points, const std::vector<unsigned int> & remap,
+                               const std::vector<unsigned char> & kinds, const std::vector<unsigned int> & loop,
+                               const std::vector<unsigned int> & loopback)
+{
+  for(size_t i = 0; i < index_count; i += 3) {
+    for(int e = 0; e < 3; ++e) {
+      const unsigned int i0 = indices[i + e];
+      const unsigned int i1 = indices[i + (e + 1) % 3];
+      const unsigned int i2 = indices[i + (e + 2) % 3];
+      const unsigned char k0 = kinds[i0];
+      const unsigned char k1 = kinds[i1];
+
+      if((!on_loop(k0) && !on_loop(k1)) || (on_loop(k0) && loop[i0] != i1) || (on_loop(k1) && loopback[i1] != i0)) {
+        continue;
+      }
+
+      if(HAS_OPPOSITE[k0][k1] && remap[i1] > remap[i0]) {
+        continue;
+      }
+
+      const float weight = k0 == KIND_BORDER || k1 == KIND_BORDER ? BORDER_EDGE_WEIGHT : SEAM_EDGE_WEIGHT;
+      Quadric q;
+      quadric_from_triangle_edge(q, points[i0], points[i1], points[i2], weight);
+
+      quadric_add(quadrics[remap[i0]], q);
+      quadric_add(quadrics[remap[i1]], q);
+    }
+  }
+}
+
+// Unlike positions, attributes are kept per vertex rather than per position,
+// so each copy of a seam vertex has its own.
+static void fill_attribute_quadrics(std::vector<Quadric> & quadrics, std::vector<QuadricGradient> & gradients,
+                                    const unsigned int * indices, size_t index_count, const std::vector<Vector3> & points,
+                                    const float * attributes, size_t attribute_count)
+{
+  std::vector<QuadricGradient> g(attribute_count);
+
+  for(size_t i = 0; i < index_count; i += 3) {
+    const unsigned int i0 = indices[i];
+    const unsigned int i1 = indices[i + 1];
+    const unsigned int i2 = indices[i + 2];
+    Quadric q;
+
+    quadric_from_attributes(q, &g[0], points[i0], points[i1], points[i2], &attributes[i0 * attribute_count],
+                            &attributes[i1 * attribute_count], &attributes[i2 * attribute_count], attribute_count);
+
+    for(int k = 0; k < 3; ++k) {
+      quadric_add(quadrics[indices[i + k]], q);
+      quadric_add(&gradients[indices[i + k] * attribute_count], &g[0], attribute_count);
+    }
+  }
+}
+
+// Every edge that may collapse at least one way, once.
+static size_t pick_edge_collapses(std::vector<Collapse> & collapses, const unsigned int * indices, size_t index_count,
+                                  const std::vector<unsigned int> & remap, const std::vector<unsigned char> & kinds,
+                                  const std::vector<unsigned int> & loop)
+{
+  size_t count = 0;
+
+  for(size_t i = 0; i < index_count; i += 3) {
+    for(int e = 0; e < 3; ++e) {
+      const unsigned int i0 = indices[i + e];
+      const unsigned int i1 = indices[i + (e + 1) % 3];
+      const unsigned char k0 = kinds[i0];
+      const unsigned char k1 = kinds[i1];
+
+      // Zero length edges, which are left alone.
+      if(remap[i0] == remap[i1]) {
+        continue;
+      }
+
+      if(!CAN_COLLAPSE[k0][k1] && !CAN_COLLAPSE[k1][k0]) {
+        continue;
+      }
+
+      if(HAS_OPPOSITE[k0][k1] && remap[i1] > remap[i0]) {
+        continue;
+      }
+
+      // Two border or seam vertices not joined by their loop belong to
+      // different loops, or to the same loop at different places.
+      if(k0 == k1 && on_loop(k0) && loop[i0] != i1) {
+        continue;
+      }
+
+      Collapse & collapse = collapses[count++];
+      collapse.bidirectional = CAN_COLLAPSE[k0][k1] && CAN_COLLAPSE[k1][k0];
+      collapse.v0 = CAN_COLLAPSE[k0][k1] ? i0 : i1;
+      collapse.v1 = CAN_COLLAPSE[k0][k1] ? i1 : i0;
+    }
+  }
+
+  return count;
+}
+
+// The seam vertex the other copy of a seam vertex i0 goes to when i0 moves
+// onto i1: along the open edge running the opposite way.
+static unsigned int seam_pair_target(unsigned int i0, unsigned int i1, const std::vector<unsigned int> & wedge,
+                                     const std::vector<unsigned int> & loop, const std::vector<unsigned int> & loopback)
+{
+  const unsigned int s0 = wedge[i0];
+  return loop[i0] == i1 ? loopback[s0] : loop[s0];
+}
+
+struct SimplifyState {
+  std::vector<Vector3> points;
+  std::vector<unsigned int> remap;
+  std::vector<unsigned int> wedge;
+  std::vector<unsigned char> kinds;
+  std::vector<unsigned int> loop;
+  std::vector<unsigned int> loopback;
+  std::vector<Quadric> vertex_quadrics;
+  std::vector<Quadric> attribute_quadrics;
+  std::vector<QuadricGradient> attribute_gradients;
+  const float * attributes;
+  size_t attribute_count;
+};
+
+// Returns false for seam collapses whose other half cannot be found.
+static bool collapse_error(const SimplifyState & state, unsigned int i0, unsigned int i1, float & error, float & distance)
+{
+  distance = quadric_error(state.vertex_quadrics[state.remap[i0]], state.points[i1]);
+  error = distance;
+
+  if(state.attribute_count == 0) {
+    return true;
+  }
+
+  const size_t count = state.attribute_count;
+  error += quadric_error(state.attribute_quadrics[i0], &state.attribute_gradients[i0 * count], count, state.points[i1],
+                         &state.attributes[i1 * count]);
+
+  if(state.kinds[i0] == KIND_SEAM) {
+    const unsigned int s0 = state.wedge[i0];
+    const unsigned int s1 = seam_pair_target(i0, i1, state.wedge, state.loop, state.loopback);
+
+    if(s1 == NO_VERTEX) {
+      return false;
+    }
+
+    error += quadric_error(state.attribute_quadrics[s0], &state.attribute_gradients[s0 * count], count, state.points[s1],
+                           &state.attributes[s1 * count]);
+  }
+
+  return true;
+}
+
+// Picks the cheaper way round for edges that can collapse either way.
+static void rank_edge_collapses(std::vector<Collapse> & collapses, size_t count, const SimplifyState & state)
+{
+  for(size_t i = 0; i < count; ++i) {
+    Collapse & collapse = collapses[i];
+    const unsigned int i0 = collapse.v0;
+    const unsigned int i1 = collapse.v1;
+    float error = FLT_MAX;
+    float distance = FLT_MAX;
+
+    if(!collapse_error(state, i0, i1, error, distance)) {
+      error = distance = FLT_MAX;
+    }
+
+    float reverse_error = FLT_MAX;
+    float reverse_distance = FLT_MAX;
+
+    if(collapse.bidirectional && collapse_error(state, i1, i0, reverse_error, reverse_distance) && reverse_error < error) {
+      collapse.v0 = i1;
+      collapse.v1 = i0;
+      error = reverse_error;
+      distance = reverse_distance;
+    }
+
+    collapse.error = error;
+    collapse.distance = distance;
+  }
+}
+
+static bool has_triangle_flip(const Vector3 & a, const Vector3 & b, const Vector3 & c, const Vector3 & d)
+{
+  const Vector3 eb = subtract(b, a);
+  const Vector3 ec = subtract(c, a);
+  const Vector3 ed = subtract(d, a);
+
+  return dot(cross(eb, ec), cross(eb, ed)) <= 0;
+}
+
+// Whether moving the position r0 onto r1 turns any of r0's other triangles
+// over. The adjacency is welded, so both are positions, as are the
+// neighbours once mapped through the collapses made so far.
+static bool has_triangle_flips(const EdgeAdjacency & welded, const std::vector<Vector3> & points, const std::vector<unsigned int> & remap,
+                               const std::vector<unsigned int> & collapse_remap, unsigned int r0, unsigned int r1)
+{
+  const EdgeAdjacency::Edge * edges = &welded.data[0] + welded.offsets[r0];
+
+  for(unsigned int i = 0; i < welded.counts[r0]; ++i) {
+    const unsigned int a = remap[collapse_remap[edges[i].next]];
+    const unsigned int b = remap[collapse_remap[edges[i].prev]];
+
+    // Triangles this collapse, or an earlier one, removes.
+    if(a == r1 || b == r1 || a == b) {
+      continue;
+    }
+
+    if(has_triangle_flip(points[a], points[b], points[r0], points[r1])) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// The link condition: the only positions next to both r0 and r1 may be the
+// corners facing their edge, otherwise the collapse pinches the surface
+// into a fold or a fin.
+static bool breaks_link_condition(const EdgeAdjacency & welded, const std::vector<unsigned int> & remap,
+                                  const std::vector<unsigned int> & collapse_remap, unsigned int r0, unsigned int r1,
+                                  std::vector<unsigned int> & scratch)
+{
+  const EdgeAdjacency::Edge * edges0 = &welded.data[0] + welded.offsets[r0];
+  const EdgeAdjacency::Edge * edges1 = &welded.data[0] + welded.offsets[r1];
+
+  // Corners facing the edge, from r0's triangles that hold r1.
+  scratch.clear();
+
+  for(unsigned int i = 0; i < welded.counts[r0]; ++i) {
+    const unsigned int a = remap[collapse_remap[edges0[i].next]];
+    const unsigned int b = remap[collapse_remap[edges0[i].prev]];
+
+    if(a == r1 && b != r1) {
+      scratch.push_back(b);
+    } else if(b == r1 && a != r1) {
+      scratch.push_back(a);
+    }
+  }
+
+  for(unsigned int i = 0; i < welded.counts[r0]; ++i) {
+    for(int k = 0; k < 2; ++k) {
+      const unsigned int n = remap[collapse_remap[k == 0 ? edges0[i].next : edges0[i].prev]];
+
+      if(n == r1 || n == r0 || std::find(scratch.begin(), scratch.end(), n) != scratch.end()) {
+        continue;
+      }
+
+      for(unsigned int j = 0; j < welded.counts[r1]; ++j) {
+        if(remap[collapse_remap[edges1[j].next]] == n || remap[collapse_remap[edges1[j].prev]] == n) {
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+// Applies the cheapest collapses to `collapse_remap`, leaving alone any
+// vertex already moved or moved onto in this pass so that the ranking stays
+// valid. A pass stops early once collapses cost well above the one that
+// would reach the goal on its own, since later ones are ranked on quadrics
+// that this pass is changing.
+static size_t perform_edge_collapses(std::vector<unsigned int> & collapse_remap, std::vector<unsigned char> & collapse_locked,
+                                     SimplifyState & state, const std::vector<Collapse> & collapses, size_t count,
+                                     const EdgeAdjacency & adjacency, size_t triangle_collapse_goal, float error_limit,
+                                     float & result_error)
+{
+  size_t edge_collapses = 0;
+  size_t triangle_collapses = 0;
+  // Most collapses remove two triangles.
+  size_t edge_collapse_goal = triangle_collapse_goal / 2;
+  const size_t attribute_count = state.attribute_count;
+  std::vector<unsigned int> scratch;
+
+  for(size_t i = 0; i < count && triangle_collapses < triangle_collapse_goal; ++i) {
+    const Collapse & collapse = collapses[i];
+
+    if(collapse.error == FLT_MAX) {
+      break;
+    }
+
+    const float error_goal = edge_collapse_goal < count ? 1.5f * collapses[edge_collapse_goal].error : FLT_MAX;
+
+    // Each collapse locks about six others, so keep going while too few
+    // have been done for that to explain running past the goal.
+    if(collapse.error > error_goal && triangle_collapses > triangle_collapse_goal / 6) {
+      break;
+    }
+
+    if(collapse.distance > error_limit) {
+      continue;
+    }
+
+    const unsigned int i0 = collapse.v0;
+    const unsigned int i1 = collapse.v1;
+    const unsigned int r0 = state.remap[i0];
+    const unsigned int r1 = state.remap[i1];
+
+    if(collapse_locked[r0] || collapse_locked[r1]) {
+      continue;
+    }
+
+    if(has_triangle_flips(adjacency, state.points, state.remap, collapse_remap, r0, r1) ||
+       breaks_link_condition(adjacency, state.remap, collapse_remap, r0, r1, scratch)) {
+      // Rejected collapses do not count towards the goal's estimate.
+      ++edge_collapse_goal;
+      continue;
+    }
+
+    quadric_add(state.vertex_quadrics[r1], state.vertex_quadrics[r0]);
+
+    if(state.kinds[i0] == KIND_SEAM) {
+      const unsigned int s0 = state.wedge[i0];
+      const unsigned int s1 = seam_pair_target(i0, i1, state.wedge, state.loop, state.loopback);
+
+      if(attribute_count > 0) {
+        quadric_add(state.attribute_quadrics[s1], state.attribute_quadrics[s0]);
+        quadric_add(&state.attribute_gradients[s1 * attribute_count], &state.attribute_gradients[s0 * attribute_count], attribute_count);
+      }
+
+      collapse_remap[s0] = s1;
+    }
+
+    if(attribute_count > 0) {
+      quadric_add(state.attribute_quadrics[i1], state.attribute_quadrics[i0]);
+      quadric_add(&state.attribute_gradients[i1 * attribute_count], &state.attribute_gradients[i0 * attribute_count], attribute_count);
+    }
+
+    // Every copy of a complex vertex goes to the one target, the attribute
+    // seams through it closing up.
+    if(state.kinds[i0] == KIND_COMPLEX) {
+      unsigned int v = i0;
+
+      do {
+        collapse_remap[v] = i1;
+        v = state.wedge[v];
+      } while(v != i0);
+    }
+
+    collapse_remap[i0] = i1;
+    collapse_locked[r0] = 1;
+    collapse_locked[r1] = 1;
+
+    // A border edge has a single triangle.
+    triangle_collapses += state.kinds[i0] == KIND_BORDER ? 1 : 2;
+    edge_collapses += 1;
+    result_error = std::max(result_error, collapse.distance);
+  }
+
+  return edge_collapses;
+}
+
+// Loops pointing at a vertex that moved follow it; a loop from a vertex
+// onto which its successor moved skips ahead to the successor's successor,
+// which may have moved in the same pass. Vertices that moved are not moved
+// onto, so remapping an entry that was already remapped changes nothing and
+// the result does not depend on the order entries are visited in.
+static void remap_edge_loops(std::vector<unsigned int> & loop, const std::vector<unsigned int> & collapse_remap)
+{
+  for(size_t v = 0; v < loop.size(); ++v) {
+    if(loop[v] != NO_VERTEX) {
+      const unsigned int l = loop[v];
+      const unsigned int r = collapse_remap[l];
+
+      if(r != v) {
+        loop[v] = r;
+      } else {
+        loop[v] = loop[l] == NO_VERTEX ? NO_VERTEX : collapse_remap[loop[l]];
+      }
+    }
+  }
+}
+
+// Drops the triangles left with two corners at the same position, which
+// includes those joining two copies of a vertex after a vertex next to both
+// moved onto one of them.
+static size_t remap_index_buffer(unsigned int * indices, size_t index_count, const std::vector<unsigned int> & collapse_remap,
+                                 const std::vector<unsigned int> & remap)
+{
+  size_t write = 0;
+
+  for(size_t i = 0; i < index_count; i += 3) {
+    const unsigned int v0 = collapse_remap[indices[i]];
+    const unsigned int v1 = collapse_remap[indices[i + 1]];
+    const unsigned int v2 = collapse_remap[indices[i + 2]];
+
+    if(remap[v0] != remap[v1] && remap[v0] != remap[v2] && remap[v1] != remap[v2]) {
+      indices[write] = v0;
+      indices[write + 1] = v1;
+      indices[write + 2] = v2;
+      write += 3;
+    }
+  }
+
+  return write;
+}
+
+size_t simplify(unsigned int * destination, const unsigned int * indices, size_t index_count,
+                const float * positions, size_t vertex_count, size_t position_stride,
+                const float * attributes, size_t attribute_count, const unsigned char * vertex_lock, bool lock_border,
+                size_t target_index_count, float target_error, float * result_error)
+{
+  if(destination != indices) {
+    memmove(destination, indices, index_count * sizeof(unsigned int));
+  }
+
+  *result_error = 0.f;
+
+  if(index_count <= target_index_count || vertex_count == 0) {
+    return index_count;
+  }
+
+  SimplifyState state;
+  state.attributes = attributes;
+  state.attribute_count = attribute_count;
+
+  // Copies of a vertex at the same position, in a circular list.
+  state.remap.resize(vertex_count);
+  state.wedge.resize(vertex_count);
+  build_position_remap(&state.remap[0], positions, vertex_count, position_stride);
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    state.wedge[v] = static_cast<unsigned int>(v);
+  }
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    const unsigned int r = state.remap[v];
+
+    if(r != v) {
+      state.wedge[v] = state.wedge[r];
+      state.wedge[r] = static_cast<unsigned int>(v);
+    }
+  }
+
+  EdgeAdjacency adjacency;
+  EdgeAdjacency welded;
+  update_edge_adjacency(adjacency, destination, index_count, vertex_count, NULL);
+  update_edge_adjacency(welded, destination, index_count, vertex_count, &state.remap[0]);
+  classify_vertices(state.kinds, state.loop, state.loopback, adjacency, welded, state.remap, state.wedge, vertex_lock,
+                    lock_border);
+
+  rescale_positions(state.points, positions, vertex_count, position_stride);
+
+  Quadric zero;
+  memset(&zero, 0, sizeof(zero));
+  state.vertex_quadrics.assign(vertex_count, zero);
+  fill_face_quadrics(state.vertex_quadrics, destination, index_count, state.points, state.remap);
+  fill_edge_quadrics(state.vertex_quadrics, destination, index_count, state.points, state.remap, state.kinds, state.loop,
+                     state.loopback);
+
+  if(attribute_count > 0) {
+    const QuadricGradient zero_gradient = { 0.f, 0.f, 0.f, 0.f };
+    state.attribute_quadrics.assign(vertex_count, zero);
+    state.attribute_gradients.assign(vertex_count * attribute_count, zero_gradient);
+    fill_attribute_quadrics(state.attribute_quadrics, state.attribute_gradients, destination, index_count, state.points,
+                            attributes, attribute_count);
+  }
+
+  std::vector<Collapse> collapses(index_count);
+  std::vector<unsigned int> collapse_remap(vertex_count);
+  std::vector<unsigned char> collapse_locked(vertex_count);
+  const float error_limit = target_error * target_error;
+  float squared_error = 0.f;
+  size_t result_count = index_count;
+
+  while(result_count > target_index_count) {
+    // Welded, so that flips are checked across seams too.
+    update_edge_adjacency(adjacency, destination, result_count, vertex_count, &state.remap[0]);
+
+    const size_t collapse_count = pick_edge_collapses(collapses, destination, result_count, state.remap, state.kinds, state.loop);
+
+    if(collapse_count == 0) {
+      break;
+    }
+
+    rank_edge_collapses(collapses, collapse_count, state);
+    std::sort(collapses.begin(), collapses.begin() + collapse_count, Collapse::cheaper);
+
+    for(size_t v = 0; v < vertex_count; ++v) {
+      collapse_remap[v] = static_cast<unsigned int>(v);
+    }
+
+    std::fill(collapse_locked.begin(), collapse_locked.end(), 0);
+
+    const size_t triangle_collapse_goal = (result_count - target_index_count) / 3;
+
+    if(perform_edge_collapses(collapse_remap, collapse_locked, state, collapses, collapse_count, adjacency,
+                              triangle_collapse_goal, error_limit, squared_error) == 0) {
+      break;
+    }
+
+    remap_edge_loops(state.loop, collapse_remap);
+    remap_edge_loops(state.loopback, collapse_remap);
+
+    result_count = remap_index_buffer(destination, result_count, collapse_remap, state.remap);
+  }
+
+  *result_error = sqrtf(squared_error);
+
+  return result_count;
+}
+
+} // namespace Fbx2Json
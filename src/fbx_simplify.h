@@ -0,0 +1,94 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * The simplifier is derived from simplifier.cpp of meshoptimizer
+ * (https://github.com/zeux/meshoptimizer), which carries this notice:
+ *
+ * Copyright (c) 2016-2024 Arseny Kapoulkine
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXSIMPLIFY_H_
+#define FBX2JSON_FBXSIMPLIFY_H_
+
+#include <cstddef>
+
+namespace Fbx2Json
+{
+
+// Maps every vertex to the first vertex with exactly the same position, so
+// that copies made along uv or normal seams can be told apart from distinct
+// points. `positions` holds three floats per vertex, `position_stride`
+// floats apart.
+void build_position_remap(unsigned int * remap, const float * positions, size_t vertex_count, size_t position_stride);
+
+// Largest side of the positions' bounding box, the unit simplify's errors
+// are given in.
+float simplify_scale(const float * positions, size_t vertex_count, size_t position_stride);
+
+// Reduces a triangle list by collapsing edges onto one of their vertices in
+// order of quadric error (Garland and Heckbert, "Surface Simplification Using
+// Quadric Error Metrics"), until no more than `target_index_count` indices are
+// left or every remaining collapse would move the surface further than
+// `target_error`. Both errors are fractions of simplify_scale. Returns the
+// number of indices written to `destination`, which may alias `indices`;
+// surviving triangles keep their order. `result_error` receives the largest
+// error reached.
+//
+// `attributes` holds `attribute_count` floats per vertex (none when 0),
+// scaled by how much each one matters. Collapses that change them are ranked
+// later, as with Hoppe's "New Quadric Metric for Simplifying Meshes with
+// Appearance Attributes", but do not count towards `target_error`.
+//
+// The collapse classification, ranking and error bookkeeping follow
+// meshoptimizer's meshopt_simplify, from which this code is derived.
+//
+// Vertices on uv or normal seams only move along the seam and vertices on open
+// borders only along the border, or not at all with `lock_border`. Vertices
+// sharing a position with one whose `vertex_lock` entry is non-zero never
+// move; `vertex_lock` may be NULL.
+size_t simplify(unsigned int * destination, const unsigned int * indices, size_t index_count,
+                const float * positions, size_t vertex_count, size_t position_stride,
+                const float * attributes, size_t attribute_count, const unsigned char * vertex_lock, bool lock_border,
+                size_t target_index_count, float target_error, float * result_error);
+
+} // namespace Fbx2Json
+
+#endif
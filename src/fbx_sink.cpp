@@ -0,0 +1,72 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "fbx_sink.h"
+
+namespace Fbx2Json
+{
+
+const size_t FILE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+FileSink::FileSink(const std::string path) : file(NULL), buffer(FILE_BUFFER_SIZE), failed(false)
+{
+  file = fopen(path.c_str(), "wb");
+
+  if(file) {
+    setvbuf(file, &buffer[0], _IOFBF, buffer.size());
+  }
+}
+
+bool FileSink::write(const char * data, size_t size)
+{
+  if(!file || failed) {
+    return false;
+  }
+
+  if(fwrite(data, 1, size, file) != size) {
+    failed = true;
+  }
+
+  return !failed;
+}
+
+bool FileSink::close()
+{
+  if(!file) {
+    return false;
+  }
+
+  if(fclose(file) != 0) {
+    failed = true;
+  }
+
+  file = NULL;
+
+  return !failed;
+}
+
+FileSink::~FileSink()
+{
+  close();
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXSINK_H_
+#define FBX2JSON_FBXSINK_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Fbx2Json
+{
+
+// Destination for serialised output. Writers push large chunks of bytes into a
+// sink, so they never need to hold a complete output file in memory.
+class Sink
+{
+  public:
+    virtual ~Sink() {}
+    virtual bool write(const char * data, size_t size) = 0;
+    virtual bool close() = 0;
+};
+
+class FileSink : public Sink
+{
+  public:
+    FileSink(const std::string path);
+    ~FileSink();
+    bool is_open() const {
+      return file != NULL;
+    }
+    bool write(const char * data, size_t size);
+    bool close();
+
+  private:
+    FILE * file;
+    std::vector<char> buffer;
+    bool failed;
+};
+
+// Collects everything written to it in memory.
+class MemorySink : public Sink
+{
+  public:
+    bool write(const char * data, size_t size) {
+      buffer.insert(buffer.end(), data, data + size);
+      return true;
+    }
+    bool close() {
+      return true;
+    }
+    const std::vector<char> & get_data() const {
+      return buffer;
+    }
+
+  private:
+    std::vector<char> buffer;
+};
+
+} // namespace Fbx2Json
+
+#endif
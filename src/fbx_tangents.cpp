@@ -0,0 +1,294 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <vector>
+#include "fbx_parallel.h"
+#include "fbx_tangents.h"
+
+namespace Fbx2Json
+{
+
+// Triangles or vertices handed to a thread at a time.
+const size_t TANGENT_CHUNK_SIZE = 16384;
+
+// Each corner's angle-weighted tangent and bitangent, projected onto its
+// vertex's tangent plane.
+const int CORNER_FRAME_SIZE = 6;
+
+const unsigned int NO_COPY = ~0u;
+
+struct TangentJob {
+  float * tangents;
+  const unsigned int * indices;
+  size_t triangle_count;
+  const float * positions;
+  size_t position_stride;
+  const float * normals;
+  const float * uvs;
+  size_t vertex_count;
+  // Vertices copied by those appended past vertex_count.
+  const unsigned int * copies;
+  std::vector<float> corner_frames;
+  // Sign of each triangle's uv area, 0 when it has none.
+  std::vector<signed char> orientations;
+  // Corners of each vertex: corners[offsets[v] .. offsets[v + 1]).
+  std::vector<unsigned int> offsets;
+  std::vector<unsigned int> corners;
+};
+
+static inline float dot(const float * a, const float * b)
+{
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static inline void cross(const float * a, const float * b, float * result)
+{
+  result[0] = a[1] * b[2] - a[2] * b[1];
+  result[1] = a[2] * b[0] - a[0] * b[2];
+  result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static inline bool normalize(float * v)
+{
+  const float length = std::sqrt(dot(v, v));
+
+  if(length <= 0.f || !(length == length)) {
+    return false;
+  }
+
+  v[0] /= length;
+  v[1] /= length;
+  v[2] /= length;
+
+  return true;
+}
+
+// Removes the component of `v` along the unit vector `n`.
+static inline void project(float * v, const float * n)
+{
+  const float d = dot(v, n);
+
+  v[0] -= d * n[0];
+  v[1] -= d * n[1];
+  v[2] -= d * n[2];
+}
+
+static void compute_corner_frames(size_t chunk, void * context)
+{
+  TangentJob * job = static_cast<TangentJob *>(context);
+  const size_t end = (chunk + 1) * TANGENT_CHUNK_SIZE < job->triangle_count ? (chunk + 1) * TANGENT_CHUNK_SIZE : job->triangle_count;
+
+  for(size_t t = chunk * TANGENT_CHUNK_SIZE; t < end; ++t) {
+    const unsigned int * triangle = &job->indices[t * 3];
+    const float * p[3];
+    const float * uv[3];
+
+    for(int k = 0; k < 3; ++k) {
+      p[k] = &job->positions[triangle[k] * job->position_stride];
+      uv[k] = &job->uvs[triangle[k] * 2];
+    }
+
+    const float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+    const float e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+    const float s1 = uv[1][0] - uv[0][0];
+    const float t1 = uv[1][1] - uv[0][1];
+    const float s2 = uv[2][0] - uv[0][0];
+    const float t2 = uv[2][1] - uv[0][1];
+
+    // As in MikkTSpace the uv area only contributes its sign, so that
+    // triangles with tiny uvs are not weighted up. Triangles with no uv area
+    // give no direction at all.
+    const float area = s1 * t2 - s2 * t1;
+    const float orientation = area > 0.f ? 1.f : (area < 0.f ? -1.f : 0.f);
+
+    job->orientations[t] = static_cast<signed char>(orientation);
+    float tangent[3];
+    float bitangent[3];
+
+    for(int i = 0; i < 3; ++i) {
+      tangent[i] = (t2 * e1[i] - t1 * e2[i]) * orientation;
+      bitangent[i] = (s1 * e2[i] - s2 * e1[i]) * orientation;
+    }
+
+    for(int k = 0; k < 3; ++k) {
+      const float * normal = &job->normals[triangle[k] * 3];
+      const float * next = p[(k + 1) % 3];
+      const float * previous = p[(k + 2) % 3];
+      float to_next[3] = { next[0] - p[k][0], next[1] - p[k][1], next[2] - p[k][2] };
+      float to_previous[3] = { previous[0] - p[k][0], previous[1] - p[k][1], previous[2] - p[k][2] };
+      float * frame = &job->corner_frames[(t * 3 + k) * CORNER_FRAME_SIZE];
+      float corner_tangent[3] = { tangent[0], tangent[1], tangent[2] };
+      float corner_bitangent[3] = { bitangent[0], bitangent[1], bitangent[2] };
+
+      project(corner_tangent, normal);
+      project(corner_bitangent, normal);
+
+      // Corners of degenerate triangles contribute nothing.
+      float weight = 0.f;
+
+      if(normalize(to_next) && normalize(to_previous) && normalize(corner_tangent)) {
+        const float cosine = dot(to_next, to_previous);
+        weight = std::acos(cosine < -1.f ? -1.f : (cosine > 1.f ? 1.f : cosine));
+      }
+
+      if(!normalize(corner_bitangent)) {
+        corner_bitangent[0] = corner_bitangent[1] = corner_bitangent[2] = 0.f;
+      }
+
+      for(int i = 0; i < 3; ++i) {
+        frame[i] = corner_tangent[i] * weight;
+        frame[3 + i] = corner_bitangent[i] * weight;
+      }
+    }
+  }
+}
+
+// Any unit vector perpendicular to the normal, for vertices whose uvs give
+// no direction.
+static void perpendicular(const float * normal, float * tangent)
+{
+  const float axis[3] = { std::fabs(normal[0]) < 0.9f ? 1.f : 0.f, std::fabs(normal[0]) < 0.9f ? 0.f : 1.f, 0.f };
+
+  tangent[0] = axis[0];
+  tangent[1] = axis[1];
+  tangent[2] = axis[2];
+  project(tangent, normal);
+
+  if(!normalize(tangent)) {
+    tangent[0] = 1.f;
+    tangent[1] = 0.f;
+    tangent[2] = 0.f;
+  }
+}
+
+static void sum_vertex_frames(size_t chunk, void * context)
+{
+  TangentJob * job = static_cast<TangentJob *>(context);
+  const size_t total_count = job->offsets.size() - 1;
+  const size_t end = (chunk + 1) * TANGENT_CHUNK_SIZE < total_count ? (chunk + 1) * TANGENT_CHUNK_SIZE : total_count;
+
+  for(size_t v = chunk * TANGENT_CHUNK_SIZE; v < end; ++v) {
+    const size_t source = v < job->vertex_count ? v : job->copies[v - job->vertex_count];
+    const float * normal = &job->normals[source * 3];
+    float * tangent = &job->tangents[v * 4];
+    float bitangent[3] = { 0.f, 0.f, 0.f };
+
+    tangent[0] = tangent[1] = tangent[2] = 0.f;
+
+    for(unsigned int i = job->offsets[v]; i < job->offsets[v + 1]; ++i) {
+      const float * frame = &job->corner_frames[job->corners[i] * CORNER_FRAME_SIZE];
+
+      for(int k = 0; k < 3; ++k) {
+        tangent[k] += frame[k];
+        bitangent[k] += frame[3 + k];
+      }
+    }
+
+    project(tangent, normal);
+
+    if(!normalize(tangent)) {
+      perpendicular(normal, tangent);
+    }
+
+    float expected[3];
+    cross(normal, tangent, expected);
+    tangent[3] = dot(expected, bitangent) < 0.f ? -1.f : 1.f;
+  }
+}
+
+void generate_tangents(std::vector<float> & tangents, std::vector<unsigned int> & copies, unsigned int * indices,
+                       size_t index_count, const float * positions, size_t position_stride, const float * normals,
+                       const float * uvs, size_t vertex_count, int thread_count)
+{
+  TangentJob job;
+
+  job.indices = indices;
+  job.triangle_count = index_count / 3;
+  job.positions = positions;
+  job.position_stride = position_stride;
+  job.normals = normals;
+  job.uvs = uvs;
+  job.vertex_count = vertex_count;
+  job.corner_frames.resize(job.triangle_count * 3 * CORNER_FRAME_SIZE);
+  job.orientations.resize(job.triangle_count);
+
+  parallel_for((job.triangle_count + TANGENT_CHUNK_SIZE - 1) / TANGENT_CHUNK_SIZE, compute_corner_frames, &job, thread_count);
+
+  // Vertices used by triangles of both orientations, where mirrored uvs
+  // meet, are split: the corners of the mirrored triangles move to a copy.
+  // Triangles with no uv area stay with the original.
+  std::vector<unsigned char> sides(vertex_count, 0);
+  std::vector<unsigned int> copy_index(vertex_count, NO_COPY);
+
+  for(size_t i = 0; i < job.triangle_count * 3; ++i) {
+    const signed char orientation = job.orientations[i / 3];
+
+    if(orientation != 0) {
+      sides[indices[i]] |= orientation > 0 ? 1 : 2;
+    }
+  }
+
+  copies.clear();
+
+  for(size_t i = 0; i < job.triangle_count * 3; ++i) {
+    const unsigned int v = indices[i];
+
+    if(sides[v] == 3 && job.orientations[i / 3] < 0) {
+      if(copy_index[v] == NO_COPY) {
+        copy_index[v] = static_cast<unsigned int>(vertex_count + copies.size());
+        copies.push_back(v);
+      }
+
+      indices[i] = copy_index[v];
+    }
+  }
+
+  const size_t total_count = vertex_count + copies.size();
+
+  job.copies = copies.empty() ? NULL : &copies[0];
+  tangents.resize(total_count * 4);
+  job.tangents = tangents.empty() ? NULL : &tangents[0];
+
+  // Corners are listed per vertex in index order, so sums do not depend on
+  // how the work was split.
+  job.offsets.assign(total_count + 1, 0);
+  job.corners.resize(job.triangle_count * 3);
+
+  for(size_t i = 0; i < job.triangle_count * 3; ++i) {
+    ++job.offsets[indices[i] + 1];
+  }
+
+  for(size_t v = 0; v < total_count; ++v) {
+    job.offsets[v + 1] += job.offsets[v];
+  }
+
+  std::vector<unsigned int> fill(job.offsets.begin(), job.offsets.end() - 1);
+
+  for(size_t i = 0; i < job.triangle_count * 3; ++i) {
+    job.corners[fill[indices[i]]++] = static_cast<unsigned int>(i);
+  }
+
+  parallel_for((total_count + TANGENT_CHUNK_SIZE - 1) / TANGENT_CHUNK_SIZE, sum_vertex_frames, &job, thread_count);
+}
+
+} // namespace Fbx2Json
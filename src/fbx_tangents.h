@@ -0,0 +1,55 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXTANGENTS_H_
+#define FBX2JSON_FBXTANGENTS_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace Fbx2Json
+{
+
+// Generates a tangent per vertex of an indexed triangle list, following the
+// conventions of MikkTSpace: each triangle's tangent and bitangent come from
+// its uv derivatives, are projected onto the tangent plane of each corner's
+// normal, and are summed per vertex weighted by the corner's angle. Tangents
+// are written as XYZW, the unit tangent in XYZ and the handedness in W, so
+// that bitangent = cross(normal, tangent.xyz) * tangent.w.
+//
+// As in MikkTSpace, vertices where mirrored uvs meet are split so that each
+// side keeps its own frame: the corners of triangles whose uvs wind the other
+// way move to a copy of the vertex, numbered from `vertex_count` on, and
+// `indices` are rewritten to use it. `copies` receives the vertex each copy
+// was made from, for the caller to duplicate its other attributes.
+//
+// `positions` hold three floats per vertex `position_stride` floats apart,
+// `normals` three and `uvs` two floats per vertex, packed. `tangents`
+// receives four floats per vertex, copies included. The work is spread over
+// `thread_count` threads and the result does not depend on their number.
+void generate_tangents(std::vector<float> & tangents, std::vector<unsigned int> & copies, unsigned int * indices,
+                       size_t index_count, const float * positions, size_t position_stride, const float * normals,
+                       const float * uvs, size_t vertex_count, int thread_count);
+
+} // namespace Fbx2Json
+
+#endif
@@ -0,0 +1,214 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include "fbx_triangulate.h"
+
+namespace Fbx2Json
+{
+
+// Twice the signed area of the 2D triangle a, b, c: positive when it turns
+// the polygon's way.
+static inline float turn(const float * a, const float * b, const float * c)
+{
+  return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+// Whether p lies inside or on the 2D triangle a, b, c, which turns the
+// polygon's way.
+static inline bool in_triangle(const float * p, const float * a, const float * b, const float * c)
+{
+  return turn(a, b, p) >= 0.f && turn(b, c, p) >= 0.f && turn(c, a, p) >= 0.f;
+}
+
+static inline bool same_point(const float * a, const float * b)
+{
+  return a[0] == b[0] && a[1] == b[1];
+}
+
+static void fan(unsigned int * triangles, size_t corner_count)
+{
+  for(size_t i = 1; i + 1 < corner_count; ++i) {
+    triangles[0] = 0;
+    triangles[1] = static_cast<unsigned int>(i);
+    triangles[2] = static_cast<unsigned int>(i + 1);
+    triangles += 3;
+  }
+}
+
+// Drops the coordinate the normal leans on most, and mirrors the other two
+// if needed so that the polygon turns counter-clockwise in the plane.
+static void project(std::vector<float> & projected, const int * corners, size_t corner_count, const float * points,
+                    size_t point_stride, const double * normal)
+{
+  const double x = std::fabs(normal[0]);
+  const double y = std::fabs(normal[1]);
+  const double z = std::fabs(normal[2]);
+  const int axis = x > y && x > z ? 0 : y > z ? 1 : 2;
+  const int u = (axis + 1) % 3;
+  const int v = (axis + 2) % 3;
+  const float sign = normal[axis] < 0 ? -1.f : 1.f;
+
+  projected.resize(corner_count * 2);
+
+  for(size_t i = 0; i < corner_count; ++i) {
+    const float * point = points + corners[i] * point_stride;
+    projected[i * 2] = point[u];
+    projected[i * 2 + 1] = point[v] * sign;
+  }
+}
+
+static bool is_convex(const std::vector<float> & projected, size_t corner_count)
+{
+  for(size_t i = 0; i < corner_count; ++i) {
+    const size_t j = (i + 1) % corner_count;
+    const size_t k = (i + 2) % corner_count;
+
+    if(turn(&projected[i * 2], &projected[j * 2], &projected[k * 2]) < 0.f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Cuts off, one at a time, a convex corner whose triangle holds no reflex
+// corner, until a triangle is left.
+static size_t clip_ears(unsigned int * triangles, size_t corner_count, TriangulationScratch & scratch)
+{
+  const float * projected = &scratch.projected[0];
+  std::vector<unsigned int> & previous = scratch.previous;
+  std::vector<unsigned int> & next = scratch.next;
+  std::vector<unsigned char> & reflex = scratch.reflex;
+
+  previous.resize(corner_count);
+  next.resize(corner_count);
+  reflex.resize(corner_count);
+
+  for(size_t i = 0; i < corner_count; ++i) {
+    previous[i] = static_cast<unsigned int>((i + corner_count - 1) % corner_count);
+    next[i] = static_cast<unsigned int>((i + 1) % corner_count);
+  }
+
+  for(size_t i = 0; i < corner_count; ++i) {
+    reflex[i] = turn(&projected[previous[i] * 2], &projected[i * 2], &projected[next[i] * 2]) <= 0.f;
+  }
+
+  size_t remaining = corner_count;
+  size_t written = 0;
+  unsigned int corner = 0;
+  // Corners looked at since the last ear; a full round without one means
+  // the polygon is not simple.
+  size_t misses = 0;
+
+  while(remaining > 3 && misses < remaining) {
+    const unsigned int a = previous[corner];
+    const unsigned int c = next[corner];
+    bool ear = !reflex[corner];
+
+    for(unsigned int other = next[c]; ear && other != a; other = next[other]) {
+      const float * p = &projected[other * 2];
+
+      ear = !reflex[other] || same_point(p, &projected[a * 2]) || same_point(p, &projected[corner * 2]) ||
+            same_point(p, &projected[c * 2]) ||
+            !in_triangle(p, &projected[a * 2], &projected[corner * 2], &projected[c * 2]);
+    }
+
+    if(!ear) {
+      corner = c;
+      misses += 1;
+      continue;
+    }
+
+    triangles[written * 3] = a;
+    triangles[written * 3 + 1] = corner;
+    triangles[written * 3 + 2] = c;
+    written += 1;
+
+    next[a] = c;
+    previous[c] = a;
+    remaining -= 1;
+    misses = 0;
+
+    reflex[a] = turn(&projected[previous[a] * 2], &projected[a * 2], &projected[c * 2]) <= 0.f;
+    reflex[c] = turn(&projected[a * 2], &projected[c * 2], &projected[next[c] * 2]) <= 0.f;
+
+    // Step back so that the corner before, which just changed, is tried
+    // next.
+    corner = a;
+  }
+
+  // The last triangle, or a fan over what a self-intersecting polygon left.
+  const unsigned int first = corner;
+
+  for(unsigned int b = next[first]; next[b] != first; b = next[b]) {
+    triangles[written * 3] = first;
+    triangles[written * 3 + 1] = b;
+    triangles[written * 3 + 2] = next[b];
+    written += 1;
+  }
+
+  return written;
+}
+
+size_t triangulate_polygon(unsigned int * triangles, const int * corners, const size_t corner_count, const float * points,
+                           const size_t point_stride, TriangulationScratch & scratch)
+{
+  if(corner_count < 3) {
+    return 0;
+  }
+
+  if(corner_count == 3) {
+    triangles[0] = 0;
+    triangles[1] = 1;
+    triangles[2] = 2;
+    return 1;
+  }
+
+  // Newell's method, which holds up for non-planar and concave polygons.
+  double normal[3] = { 0, 0, 0 };
+
+  for(size_t i = 0; i < corner_count; ++i) {
+    const float * a = points + corners[i] * point_stride;
+    const float * b = points + corners[(i + 1) % corner_count] * point_stride;
+
+    normal[0] += (double(a[1]) - b[1]) * (double(a[2]) + b[2]);
+    normal[1] += (double(a[2]) - b[2]) * (double(a[0]) + b[0]);
+    normal[2] += (double(a[0]) - b[0]) * (double(a[1]) + b[1]);
+  }
+
+  if(normal[0] == 0 && normal[1] == 0 && normal[2] == 0) {
+    fan(triangles, corner_count);
+    return corner_count - 2;
+  }
+
+  project(scratch.projected, corners, corner_count, points, point_stride, normal);
+
+  if(is_convex(scratch.projected, corner_count)) {
+    fan(triangles, corner_count);
+    return corner_count - 2;
+  }
+
+  return clip_ears(triangles, corner_count, scratch);
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXTRIANGULATE_H_
+#define FBX2JSON_FBXTRIANGULATE_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace Fbx2Json
+{
+
+// Working memory of triangulate_polygon, kept between calls so that large
+// polygons do not allocate each time.
+struct TriangulationScratch {
+  std::vector<float> projected;
+  std::vector<unsigned int> previous;
+  std::vector<unsigned int> next;
+  std::vector<unsigned char> reflex;
+};
+
+// Cuts a polygon of `corner_count` corners into corner_count - 2 triangles,
+// written to `triangles` as corner numbers from 0 to corner_count - 1 with
+// the polygon's winding. Corner i lies at points[corners[i] * point_stride],
+// three floats. The polygon is flattened along its Newell normal; convex
+// polygons are fanned from their first corner, concave ones are cut by ear
+// clipping. Polygons too twisted for either are fanned from whatever remains,
+// so the triangle count holds whatever the input. Returns that count, 0 for
+// fewer than three corners.
+size_t triangulate_polygon(unsigned int * triangles, const int * corners, size_t corner_count, const float * points,
+                           size_t point_stride, TriangulationScratch & scratch);
+
+} // namespace Fbx2Json
+
+#endif
@@ -20,7 +20,17 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "fbx_convert.h"
+#include "fbx_layer_element.h"
+#include "fbx_overdraw.h"
+#include "fbx_simplify.h"
+#include "fbx_tangents.h"
+#include "fbx_triangulate.h"
 #include "fbx_vbomesh.h"
+#include "fbx_vertex_cache.h"
 
 namespace Fbx2Json
 {
@@ -30,6 +40,70 @@ const int TRIANGLE_VERTEX_COUNT = 3;
 const int VERTEX_STRIDE = 4;
 const int NORMAL_STRIDE = 3;
 const int UV_STRIDE = 2;
+const int COLOR_STRIDE = 4;
+const int TANGENT_STRIDE = 4;
+
+const size_t VBOMesh::MAX_SHORT_INDEX_VERTICES;
+
+const GLuint WELD_EMPTY = 0xffffffffu;
+
+// How much normals and uvs count against positions, which the simplifier
+// scales to the unit cube, when ranking collapses for levels of detail.
+const float LOD_NORMAL_WEIGHT = 0.5f;
+const float LOD_UV_WEIGHT = 1.f;
+
+const int VBOMesh::MAX_UV_SETS;
+const int VBOMesh::MAX_COLOR_SETS;
+
+// The first uv set keeps the name "uvs", further ones are numbered.
+static const char * const UV_STREAM_NAMES[VBOMesh::MAX_UV_SETS] = {
+  "uvs", "uvs1", "uvs2", "uvs3", "uvs4", "uvs5", "uvs6", "uvs7"
+};
+static const char * const COLOR_STREAM_NAMES[VBOMesh::MAX_COLOR_SETS] = { "colors", "colors1", "colors2", "colors3" };
+
+static const char * channel_stream_name(const VBOMesh::Channel & channel)
+{
+  switch(channel.semantic) {
+    case MeshStream::SEMANTIC_TEXCOORD:
+      return UV_STREAM_NAMES[channel.set];
+
+    case MeshStream::SEMANTIC_COLOR:
+      return COLOR_STREAM_NAMES[channel.set];
+
+    default:
+      return "tangents";
+  }
+}
+
+// Resolves and copies a whole layer element, see fbx_layer_element.h.
+template<typename T>
+static bool read_element(const FbxLayerElementTemplate<T> * element, const FbxMesh * mesh, const bool by_control_point,
+                         const int components, const int stride, std::vector<float> & data)
+{
+  std::vector<int> direct_indices;
+
+  if(!resolve_element(element, mesh, by_control_point, direct_indices)) {
+    return false;
+  }
+
+  data.assign(direct_indices.size() * stride, 0.f);
+
+  return data.empty() || gather_element(element, direct_indices, components, &data[0], stride);
+}
+
+// Every word of the key goes through MurmurHash2's mixing step.
+static inline unsigned int hash_words(const unsigned int * words, const int count, unsigned int hash)
+{
+  const unsigned int m = 0x5bd1e995;
+
+  for(int i = 0; i < count; ++i) {
+    unsigned int k = words[i] * m;
+    k ^= k >> 24;
+    hash = (hash * m) ^ (k * m);
+  }
+
+  return hash ^ (hash >> 13);
+}
 
 VBOMesh::VBOMesh() : has_normal(false), has_uv(false), all_by_control_points(true)
 {
@@ -61,7 +135,15 @@ bool VBOMesh::initialize(const FbxMesh *mesh)
 
   const int polygon_count = mesh->GetPolygonCount();
 
-  // Count the polygon count of each material
+  // Polygons are triangulated here rather than by the SDK: one of n corners
+  // becomes n - 2 triangles, and those of fewer than three corners none.
+  int triangle_count = 0;
+
+  for(int i = 0; i < polygon_count; ++i) {
+    triangle_count += std::max(mesh->GetPolygonSize(i) - 2, 0);
+  }
+
+  // Count the triangle count of each material
   FbxLayerElementArrayTemplate<int>* material_indice = NULL;
   FbxGeometryElement::EMappingMode material_mapping_mode = FbxGeometryElement::eNone;
 
@@ -84,7 +166,7 @@ bool VBOMesh::initialize(const FbxMesh *mesh)
             submeshes[material_index] = new SubMesh;
           }
 
-          submeshes[material_index]->triangle_count += 1;
+          submeshes[material_index]->triangle_count += std::max(mesh->GetPolygonSize(i) - 2, 0);
         }
 
         // Make sure we have no "holes" (NULL) in the mSubMeshes table. This can happen
@@ -147,15 +229,48 @@ bool VBOMesh::initialize(const FbxMesh *mesh)
     }
   }
 
+  // Further uv sets, vertex colours and tangents become channels.
+  FbxStringList uv_names;
+  mesh->GetUVSetNames(uv_names);
+  std::vector<const FbxLayerElement *> channel_elements;
+  const int uv_set_count = std::min(uv_names.GetCount(), static_cast<int>(MAX_UV_SETS));
+  const int color_set_count = std::min(mesh->GetElementVertexColorCount(), static_cast<int>(MAX_COLOR_SETS));
+
+  if(uv_names.GetCount() > uv_set_count || mesh->GetElementVertexColorCount() > color_set_count) {
+    std::cerr << "Ignoring uv sets beyond " << MAX_UV_SETS << " and colour layers beyond " << MAX_COLOR_SETS
+              << " of mesh " << mesh->GetName() << std::endl;
+  }
+
+  for(int i = 1; i < uv_set_count; ++i) {
+    channels.push_back(Channel(MeshStream::SEMANTIC_TEXCOORD, i, UV_STRIDE));
+    channel_elements.push_back(mesh->GetElementUV(uv_names[i]));
+  }
+
+  for(int i = 0; i < color_set_count; ++i) {
+    channels.push_back(Channel(MeshStream::SEMANTIC_COLOR, i, COLOR_STRIDE));
+    channel_elements.push_back(mesh->GetElementVertexColor(i));
+  }
+
+  if(has_normal && mesh->GetElementTangentCount() > 0) {
+    channels.push_back(Channel(MeshStream::SEMANTIC_TANGENT, 0, TANGENT_STRIDE));
+    channel_elements.push_back(mesh->GetElementTangent(0));
+  }
+
+  for(size_t c = 0; c < channel_elements.size(); ++c) {
+    if(channel_elements[c] != NULL && channel_elements[c]->GetMappingMode() != FbxGeometryElement::eByControlPoint) {
+      all_by_control_points = false;
+    }
+  }
+
   // Allocate the array memory, by control point or by polygon vertex.
   int polygon_vertex_count = mesh->GetControlPointsCount();
 
   if(!all_by_control_points) {
-    polygon_vertex_count = polygon_count * TRIANGLE_VERTEX_COUNT;
+    polygon_vertex_count = mesh->GetPolygonVertexCount();
   }
 
   vertices = std::vector<float>(polygon_vertex_count * VERTEX_STRIDE);
-  indices = std::vector<GLuint>(polygon_count * TRIANGLE_VERTEX_COUNT);
+  indices = std::vector<GLuint>(triangle_count * TRIANGLE_VERTEX_COUNT);
   //  normals = NULL;
 
   if(has_normal) {
@@ -163,8 +278,6 @@ bool VBOMesh::initialize(const FbxMesh *mesh)
   }
 
   //  uvs = NULL;
-  FbxStringList uv_names;
-  mesh->GetUVSetNames(uv_names);
   const char * uv_name = NULL;
 
   if(has_uv && uv_names.GetCount()) {
@@ -172,65 +285,81 @@ bool VBOMesh::initialize(const FbxMesh *mesh)
     uv_name = uv_names[0];
   }
 
-  // Populate the array with vertex attribute, if by control point.
-  const FbxVector4 * control_points = mesh->GetControlPoints();
-  FbxVector4 current_vertex;
-  FbxVector4 current_normal;
-  FbxVector2 current_uv;
+  // Resolve where every attribute comes from once, then copy them all in one
+  // go: by control point, or by polygon vertex to be welded below.
+  const FbxGeometryElementNormal * normal_element = normals.empty() ? NULL : mesh->GetElementNormal(0);
+  const FbxGeometryElementUV * uv_element = uvs.empty() ? NULL : mesh->GetElementUV(uv_name);
 
-  if(all_by_control_points) {
-    const FbxGeometryElementNormal * normal_element = NULL;
-    const FbxGeometryElementUV * uv_element = NULL;
+  if(normal_element != NULL && !read_element(normal_element, mesh, all_by_control_points, 3, NORMAL_STRIDE, normals)) {
+    std::cerr << "Ignoring unsupported normals of mesh " << mesh->GetName() << std::endl;
+    has_normal = false;
+    std::vector<float>().swap(normals);
+  }
 
-    if(has_normal) {
-      normal_element = mesh->GetElementNormal(0);
-    }
+  if(uv_element != NULL && !read_element(uv_element, mesh, all_by_control_points, 2, UV_STRIDE, uvs)) {
+    std::cerr << "Ignoring unsupported uvs of mesh " << mesh->GetName() << std::endl;
+    has_uv = false;
+    std::vector<float>().swap(uvs);
+  }
 
-    if(has_uv) {
-      uv_element = mesh->GetElementUV(0);
+  for(size_t c = 0; c < channels.size(); ) {
+    if(channel_elements[c] == NULL || !read_channel(mesh, channel_elements[c], channels[c])) {
+      std::cerr << "Ignoring unsupported " << channel_stream_name(channels[c]) << " of mesh " << mesh->GetName() << std::endl;
+      channels.erase(channels.begin() + c);
+      channel_elements.erase(channel_elements.begin() + c);
+    } else {
+      ++c;
     }
+  }
 
-    for(int i = 0; i < polygon_vertex_count; ++i) {
-      // Save the vertex position.
-      current_vertex = control_points[i];
-      vertices[i * VERTEX_STRIDE] = static_cast<float>(current_vertex[0]);
-      vertices[i * VERTEX_STRIDE + 1] = static_cast<float>(current_vertex[1]);
-      vertices[i * VERTEX_STRIDE + 2] = static_cast<float>(current_vertex[2]);
-      vertices[i * VERTEX_STRIDE + 3] = 1;
-
-      // Save the normal.
-      if(has_normal) {
-        int normal_index = i;
+  const FbxVector4 * control_points = mesh->GetControlPoints();
+  const int * polygon_vertices = mesh->GetPolygonVertices();
 
-        if(normal_element->GetReferenceMode() == FbxLayerElement::eIndexToDirect) {
-          normal_index = normal_element->GetIndexArray().GetAt(i);
-        }
+  // Positions are converted once per control point. Polygon-vertices copy
+  // theirs from the result.
+  std::vector<float> control_point_positions;
 
-        current_normal = normal_element->GetDirectArray().GetAt(normal_index);
-        normals[i * NORMAL_STRIDE] = static_cast<float>(current_normal[0]);
-        normals[i * NORMAL_STRIDE + 1] = static_cast<float>(current_normal[1]);
-        normals[i * NORMAL_STRIDE + 2] = static_cast<float>(current_normal[2]);
-      }
+  // Here the conversion yields the positions' box as it goes.
+  if(all_by_control_points) {
+    convert_points(vertices.empty() ? NULL : &vertices[0], reinterpret_cast<const double *>(control_points), 4, NULL,
+                   polygon_vertex_count, bounds.min, bounds.max);
+  } else {
+    control_point_positions.resize(mesh->GetControlPointsCount() * VERTEX_STRIDE);
+    convert_points(control_point_positions.empty() ? NULL : &control_point_positions[0],
+                   reinterpret_cast<const double *>(control_points), 4, NULL, mesh->GetControlPointsCount());
+  }
 
-      // Save the UV.
-      if(has_uv) {
-        int uv_index = i;
+  // Polygon-vertices identical to one already written are welded to it.
+  std::vector<GLuint> weld_table;
 
-        if(uv_element->GetReferenceMode() == FbxLayerElement::eIndexToDirect) {
-          uv_index = uv_element->GetIndexArray().GetAt(i);
-        }
+  if(!all_by_control_points) {
+    size_t table_size = 1;
 
-        current_uv = uv_element->GetDirectArray().GetAt(uv_index);
-        uvs[i * UV_STRIDE] = static_cast<float>(current_uv[0]);
-        uvs[i * UV_STRIDE + 1] = static_cast<float>(current_uv[1]);
-      }
+    while(table_size < static_cast<size_t>(polygon_vertex_count) * 2) {
+      table_size *= 2;
     }
 
+    weld_table.assign(table_size, WELD_EMPTY);
+    control_point_indices.reserve(polygon_vertex_count);
   }
 
+  // Triangles are cut in the plane of each polygon, from the positions of
+  // its control points.
+  const float * points = all_by_control_points ? (vertices.empty() ? NULL : &vertices[0]) :
+                         (control_point_positions.empty() ? NULL : &control_point_positions[0]);
+  TriangulationScratch scratch;
+  std::vector<GLuint> corner_vertices;
+  std::vector<unsigned int> polygon_triangles;
   int vertex_count = 0;
 
   for(int polygon_index = 0; polygon_index < polygon_count; ++polygon_index) {
+    const int first_corner = mesh->GetPolygonVertexIndex(polygon_index);
+    const int polygon_size = mesh->GetPolygonSize(polygon_index);
+
+    if(polygon_size < TRIANGLE_VERTEX_COUNT) {
+      continue;
+    }
+
     // The material for current face.
     int material_index = 0;
 
@@ -242,78 +371,927 @@ bool VBOMesh::initialize(const FbxMesh *mesh)
     const int index_offset = submeshes[material_index]->index_offset +
                              submeshes[material_index]->triangle_count * 3;
 
-    for(int vertice_index = 0; vertice_index < TRIANGLE_VERTEX_COUNT; ++vertice_index) {
-      const int control_point_index = mesh->GetPolygonVertex(polygon_index, vertice_index);
+    corner_vertices.resize(polygon_size);
+
+    for(int vertice_index = 0; vertice_index < polygon_size; ++vertice_index) {
+      const int corner = first_corner + vertice_index;
+      const int control_point_index = polygon_vertices[corner];
 
       if(all_by_control_points) {
-        indices[index_offset + vertice_index] = static_cast<unsigned int>(control_point_index);
+        corner_vertices[vertice_index] = static_cast<unsigned int>(control_point_index);
       }
-      // Populate the array with vertex attribute, if by polygon vertex.
+      // Populate the array with vertex attribute, if by polygon vertex. The
+      // corner's normal and uv move down to the next free vertex slot, which
+      // is never past the corner itself as corners go in order.
       else {
-        indices[index_offset + vertice_index] = static_cast<GLuint>(vertex_count);
-
-        current_vertex = control_points[control_point_index];
-        vertices[vertex_count * VERTEX_STRIDE] = static_cast<float>(current_vertex[0]);
-        vertices[vertex_count * VERTEX_STRIDE + 1] = static_cast<float>(current_vertex[1]);
-        vertices[vertex_count * VERTEX_STRIDE + 2] = static_cast<float>(current_vertex[2]);
-        vertices[vertex_count * VERTEX_STRIDE + 3] = 1;
+        memcpy(&vertices[vertex_count * VERTEX_STRIDE], &control_point_positions[control_point_index * VERTEX_STRIDE],
+               VERTEX_STRIDE * sizeof(float));
 
         if(has_normal) {
-          mesh->GetPolygonVertexNormal(polygon_index, vertice_index, current_normal);
-          normals[vertex_count * NORMAL_STRIDE] = static_cast<float>(current_normal[0]);
-          normals[vertex_count * NORMAL_STRIDE + 1] = static_cast<float>(current_normal[1]);
-          normals[vertex_count * NORMAL_STRIDE + 2] = static_cast<float>(current_normal[2]);
+          memmove(&normals[vertex_count * NORMAL_STRIDE], &normals[corner * NORMAL_STRIDE], NORMAL_STRIDE * sizeof(float));
+        }
+
+        if(!uvs.empty()) {
+          memmove(&uvs[vertex_count * UV_STRIDE], &uvs[corner * UV_STRIDE], UV_STRIDE * sizeof(float));
+        }
+
+        for(std::vector<Channel>::iterator channel = channels.begin(); channel != channels.end(); ++channel) {
+          memmove(&channel->data[vertex_count * channel->components], &channel->data[corner * channel->components],
+                  channel->components * sizeof(float));
         }
 
-        if(has_uv) {
-          mesh->GetPolygonVertexUV(polygon_index, vertice_index, uv_name, current_uv);
-          uvs[vertex_count * UV_STRIDE] = static_cast<float>(current_uv[0]);
-          uvs[vertex_count * UV_STRIDE + 1] = static_cast<float>(current_uv[1]);
+        control_point_indices.push_back(control_point_index);
+
+        const GLuint index = weld_vertex(vertex_count, weld_table);
+        corner_vertices[vertice_index] = index;
+
+        if(index == static_cast<GLuint>(vertex_count)) {
+          ++vertex_count;
+        } else {
+          control_point_indices.pop_back();
         }
       }
+    }
+
+    polygon_triangles.resize((polygon_size - 2) * TRIANGLE_VERTEX_COUNT);
+    const size_t polygon_triangle_count = triangulate_polygon(&polygon_triangles[0], polygon_vertices + first_corner,
+                                                              polygon_size, points, VERTEX_STRIDE, scratch);
+
+    for(size_t i = 0; i < polygon_triangle_count * TRIANGLE_VERTEX_COUNT; ++i) {
+      indices[index_offset + i] = corner_vertices[polygon_triangles[i]];
+    }
 
-      ++vertex_count;
+    submeshes[material_index]->triangle_count += static_cast<int>(polygon_triangle_count);
+  }
+
+  if(!all_by_control_points) {
+    vertices.resize(vertex_count * VERTEX_STRIDE);
+    normals.resize(has_normal ? vertex_count * NORMAL_STRIDE : 0);
+    uvs.resize(uvs.empty() ? 0 : vertex_count * UV_STRIDE);
+
+    for(std::vector<Channel>::iterator channel = channels.begin(); channel != channels.end(); ++channel) {
+      channel->data.resize(vertex_count * channel->components);
     }
 
-    submeshes[material_index]->triangle_count += 1;
+    // Not every control point need be used, so the box comes from the
+    // welded vertices.
+    if(vertex_count > 0) {
+      add_points(bounds, &vertices[0], VERTEX_STRIDE, NULL, vertex_count);
+    }
   }
 
+  fit_sphere(bounds, vertices.empty() ? NULL : &vertices[0], VERTEX_STRIDE, NULL, get_vertex_count());
+
   return true;
 }
 
-void VBOMesh::update_vertex_position(FbxMesh * mesh, const FbxVector4 * deformed_vertices)
+// Tangents read from the file get their handedness from the binormals, if
+// any, the same way generated ones do.
+bool VBOMesh::read_channel(const FbxMesh * mesh, const FbxLayerElement * element, Channel & channel) const
 {
-  int vertex_count = 0;
+  switch(channel.semantic) {
+    case MeshStream::SEMANTIC_TEXCOORD:
+      return read_element(static_cast<const FbxGeometryElementUV *>(element), mesh, all_by_control_points, 2,
+                          channel.components, channel.data);
+
+    case MeshStream::SEMANTIC_COLOR:
+      return read_element(static_cast<const FbxGeometryElementVertexColor *>(element), mesh, all_by_control_points, 4,
+                          channel.components, channel.data);
+
+    default:
+      break;
+  }
+
+  if(!has_normal || !read_element(static_cast<const FbxGeometryElementTangent *>(element), mesh, all_by_control_points, 3,
+                                  channel.components, channel.data)) {
+    return false;
+  }
+
+  const FbxGeometryElementBinormal * binormal_element = mesh->GetElementBinormalCount() > 0 ? mesh->GetElementBinormal(0) : NULL;
+  std::vector<float> binormals;
+
+  if(binormal_element == NULL || !read_element(binormal_element, mesh, all_by_control_points, 3, 3, binormals)) {
+    binormals.clear();
+  }
+
+  const size_t count = channel.data.size() / TANGENT_STRIDE;
+
+  for(size_t i = 0; i < count; ++i) {
+    float * tangent = &channel.data[i * TANGENT_STRIDE];
+    const float * normal = &normals[i * NORMAL_STRIDE];
+    float handedness = 1.f;
+
+    if(!binormals.empty()) {
+      const float * binormal = &binormals[i * 3];
+      const float expected[3] = {
+        normal[1] * tangent[2] - normal[2] * tangent[1],
+        normal[2] * tangent[0] - normal[0] * tangent[2],
+        normal[0] * tangent[1] - normal[1] * tangent[0],
+      };
+
+      handedness = expected[0] * binormal[0] + expected[1] * binormal[1] + expected[2] * binormal[2] < 0.f ? -1.f : 1.f;
+    }
+
+    tangent[3] = handedness;
+  }
+
+  return true;
+}
+
+// Writes the words identifying vertex `index`: its control point, then the
+// bits of its position, normal, uv and channels. Comparing bits rather than floats
+// keeps the table consistent for NaNs and signed zeros.
+int VBOMesh::vertex_key(const int index, unsigned int * words) const
+{
+  int count = 0;
+  words[count++] = static_cast<unsigned int>(control_point_indices[index]);
+
+  memcpy(&words[count], &vertices[index * VERTEX_STRIDE], 3 * sizeof(float));
+  count += 3;
+
+  if(has_normal) {
+    memcpy(&words[count], &normals[index * NORMAL_STRIDE], NORMAL_STRIDE * sizeof(float));
+    count += NORMAL_STRIDE;
+  }
+
+  if(!uvs.empty()) {
+    memcpy(&words[count], &uvs[index * UV_STRIDE], UV_STRIDE * sizeof(float));
+    count += UV_STRIDE;
+  }
+
+  for(std::vector<Channel>::const_iterator channel = channels.begin(); channel != channels.end(); ++channel) {
+    memcpy(&words[count], &channel->data[index * channel->components], channel->components * sizeof(float));
+    count += channel->components;
+  }
+
+  return count;
+}
+
+// Looks up the vertex just written at `index` in an open-addressing table of
+// the vertices before it. Returns the earlier identical vertex if there is
+// one, otherwise records `index` and returns it. Expected O(1), as the table
+// is kept at most half full.
+GLuint VBOMesh::weld_vertex(const int index, std::vector<GLuint> & table) const
+{
+  unsigned int key[MAX_VERTEX_KEY_WORDS];
+  unsigned int other[MAX_VERTEX_KEY_WORDS];
+  const int count = vertex_key(index, key);
+  const size_t mask = table.size() - 1;
+
+  for(size_t slot = hash_words(key, count, 0) & mask; ; slot = (slot + 1) & mask) {
+    if(table[slot] == WELD_EMPTY) {
+      table[slot] = static_cast<GLuint>(index);
+      return table[slot];
+    }
+
+    vertex_key(table[slot], other);
+
+    if(memcmp(key, other, count * sizeof(unsigned int)) == 0) {
+      return table[slot];
+    }
+  }
+}
+
+MeshStream VBOMesh::get_index_stream() const
+{
+  if(!short_indices.empty()) {
+    return MeshStream("indices", MeshStream::SEMANTIC_INDEX, MeshStream::FORMAT_UINT16, 1, 1, short_indices.size(),
+                      &short_indices[0]);
+  }
+
+  return MeshStream("indices", MeshStream::SEMANTIC_INDEX, MeshStream::FORMAT_UINT32, 1, 1, indices.size(),
+                    indices.empty() ? NULL : &indices[0]);
+}
+
+void VBOMesh::get_vertex_streams(std::vector<MeshStream> & streams) const
+{
+  streams.push_back(MeshStream("vertices", MeshStream::SEMANTIC_POSITION, MeshStream::FORMAT_FLOAT32, 3, VERTEX_STRIDE,
+                               vertices.size() / VERTEX_STRIDE, vertices.empty() ? NULL : &vertices[0]));
+  streams.push_back(MeshStream("normals", MeshStream::SEMANTIC_NORMAL, MeshStream::FORMAT_FLOAT32, 3, NORMAL_STRIDE,
+                               normals.size() / NORMAL_STRIDE, normals.empty() ? NULL : &normals[0]));
+  streams.push_back(MeshStream("uvs", MeshStream::SEMANTIC_TEXCOORD, MeshStream::FORMAT_FLOAT32, 2, UV_STRIDE,
+                               uvs.size() / UV_STRIDE, uvs.empty() ? NULL : &uvs[0]));
+
+  for(std::vector<Channel>::const_iterator channel = channels.begin(); channel != channels.end(); ++channel) {
+    streams.push_back(MeshStream(channel_stream_name(*channel), channel->semantic, MeshStream::FORMAT_FLOAT32,
+                                 channel->components, channel->components, channel->data.size() / channel->components,
+                                 channel->data.empty() ? NULL : &channel->data[0], channel->set));
+  }
+}
+
+// Each meshlet's bounds are eleven floats: the sphere's centre and radius,
+// then the cone's apex, axis and cutoff. Its range is the four values of
+// Meshlet.
+void VBOMesh::get_meshlet_streams(std::vector<MeshStream> & streams) const
+{
+  streams.push_back(MeshStream("bounds", MeshStream::SEMANTIC_MESHLET, MeshStream::FORMAT_FLOAT32, 11, 11,
+                               meshlet_bounds.size(), meshlet_bounds.empty() ? NULL : meshlet_bounds[0].center));
+  streams.push_back(MeshStream("ranges", MeshStream::SEMANTIC_MESHLET, MeshStream::FORMAT_UINT32, 4, 4,
+                               meshlets.size(), meshlets.empty() ? NULL : &meshlets[0].vertex_offset));
+  streams.push_back(MeshStream("triangles", MeshStream::SEMANTIC_MESHLET, MeshStream::FORMAT_UINT8, 3, 3,
+                               meshlet_triangles.size() / 3, meshlet_triangles.empty() ? NULL : &meshlet_triangles[0]));
+
+  if(!short_meshlet_vertices.empty()) {
+    streams.push_back(MeshStream("vertices", MeshStream::SEMANTIC_MESHLET, MeshStream::FORMAT_UINT16, 1, 1,
+                                 short_meshlet_vertices.size(), &short_meshlet_vertices[0]));
+  } else {
+    streams.push_back(MeshStream("vertices", MeshStream::SEMANTIC_MESHLET, MeshStream::FORMAT_UINT32, 1, 1,
+                                 meshlet_vertices.size(), meshlet_vertices.empty() ? NULL : &meshlet_vertices[0]));
+  }
+}
+
+// Nodes mix floats and integers, so they are described as raw bytes.
+void VBOMesh::get_bvh_streams(std::vector<MeshStream> & streams) const
+{
+  const int node_size = static_cast<int>(sizeof(BvhNode));
+
+  streams.push_back(MeshStream("nodes", MeshStream::SEMANTIC_BVH, MeshStream::FORMAT_UINT8, node_size, node_size,
+                               bvh_nodes.size(), bvh_nodes.empty() ? NULL : &bvh_nodes[0]));
+  streams.push_back(MeshStream("triangles", MeshStream::SEMANTIC_BVH, MeshStream::FORMAT_UINT32, 1, 1,
+                               bvh_triangles.size(), bvh_triangles.empty() ? NULL : &bvh_triangles[0]));
+}
+
+MeshStream VBOMesh::Lod::get_index_stream() const
+{
+  if(!short_indices.empty()) {
+    return MeshStream("indices", MeshStream::SEMANTIC_INDEX, MeshStream::FORMAT_UINT16, 1, 1, short_indices.size(),
+                      &short_indices[0]);
+  }
+
+  return MeshStream("indices", MeshStream::SEMANTIC_INDEX, MeshStream::FORMAT_UINT32, 1, 1, indices.size(),
+                    indices.empty() ? NULL : &indices[0]);
+}
+
+// Lowers `low` and raises `high` to take in `count` indices from `range`.
+static void widen_range(const GLuint * range, const size_t count, GLuint & low, GLuint & high)
+{
+  for(size_t i = 0; i < count; ++i) {
+    low = std::min(low, range[i]);
+    high = std::max(high, range[i]);
+  }
+}
+
+// Stores `count` indices from `range` as 16-bit offsets from `base`.
+static void pack_range(const GLuint * range, const size_t count, const GLuint base, GLushort * destination)
+{
+  for(size_t i = 0; i < count; ++i) {
+    destination[i] = static_cast<GLushort>(range[i] - base);
+  }
+}
+
+bool VBOMesh::find_base_vertices(std::vector<GLuint> & bases) const
+{
+  size_t covered = 0;
+
+  bases.assign(submeshes.GetCount(), 0);
+
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    const SubMesh * submesh = submeshes[s];
+    GLuint low = ~0u;
+    GLuint high = 0;
+
+    if(submesh->triangle_count == 0) {
+      continue;
+    }
+
+    covered += submesh->triangle_count * TRIANGLE_VERTEX_COUNT;
+    widen_range(&indices[submesh->index_offset], submesh->triangle_count * TRIANGLE_VERTEX_COUNT, low, high);
+
+    // Levels of detail and meshlets only use vertices of their own submesh.
+    for(std::vector<Lod>::const_iterator lod = lods.begin(); lod != lods.end(); ++lod) {
+      const SubMesh & lod_submesh = lod->submeshes[s];
+
+      if(lod_submesh.triangle_count > 0) {
+        widen_range(&lod->indices[lod_submesh.index_offset], lod_submesh.triangle_count * TRIANGLE_VERTEX_COUNT, low, high);
+      }
+    }
+
+    for(int m = submesh->meshlet_offset; m < submesh->meshlet_offset + submesh->meshlet_count; ++m) {
+      widen_range(&meshlet_vertices[meshlets[m].vertex_offset], meshlets[m].vertex_count, low, high);
+    }
+
+    if(high - low >= MAX_SHORT_INDEX_VERTICES) {
+      return false;
+    }
+
+    bases[s] = low;
+  }
+
+  return covered == indices.size();
+}
+
+bool VBOMesh::pack_indices(const bool base_vertex)
+{
+  if(indices.empty()) {
+    return false;
+  }
+
+  std::vector<GLuint> bases;
+
+  if(get_vertex_count() <= MAX_SHORT_INDEX_VERTICES) {
+    bases.assign(submeshes.GetCount(), 0);
+  } else if(!base_vertex || !find_base_vertices(bases)) {
+    return false;
+  }
+
+  short_indices.resize(indices.size());
+
+  for(std::vector<Lod>::iterator lod = lods.begin(); lod != lods.end(); ++lod) {
+    lod->short_indices.resize(lod->indices.size());
+  }
+
+  short_meshlet_vertices.resize(meshlet_vertices.size());
+
+  // Small meshes are packed whole, as every base is 0; indices outside any
+  // submesh only occur there.
+  if(get_vertex_count() <= MAX_SHORT_INDEX_VERTICES) {
+    pack_range(&indices[0], indices.size(), 0, &short_indices[0]);
+
+    for(std::vector<Lod>::iterator lod = lods.begin(); lod != lods.end(); ++lod) {
+      if(!lod->indices.empty()) {
+        pack_range(&lod->indices[0], lod->indices.size(), 0, &lod->short_indices[0]);
+      }
+    }
+
+    if(!meshlet_vertices.empty()) {
+      pack_range(&meshlet_vertices[0], meshlet_vertices.size(), 0, &short_meshlet_vertices[0]);
+    }
+  } else {
+    for(int s = 0; s < submeshes.GetCount(); ++s) {
+      SubMesh * submesh = submeshes[s];
+
+      if(submesh->triangle_count == 0) {
+        continue;
+      }
+
+      submesh->base_vertex = static_cast<int>(bases[s]);
+      pack_range(&indices[submesh->index_offset], submesh->triangle_count * TRIANGLE_VERTEX_COUNT, bases[s],
+                 &short_indices[submesh->index_offset]);
+
+      for(std::vector<Lod>::iterator lod = lods.begin(); lod != lods.end(); ++lod) {
+        SubMesh & lod_submesh = lod->submeshes[s];
+
+        lod_submesh.base_vertex = submesh->base_vertex;
+
+        if(lod_submesh.triangle_count > 0) {
+          pack_range(&lod->indices[lod_submesh.index_offset], lod_submesh.triangle_count * TRIANGLE_VERTEX_COUNT,
+                     bases[s], &lod->short_indices[lod_submesh.index_offset]);
+        }
+      }
+
+      for(int m = submesh->meshlet_offset; m < submesh->meshlet_offset + submesh->meshlet_count; ++m) {
+        pack_range(&meshlet_vertices[meshlets[m].vertex_offset], meshlets[m].vertex_count, bases[s],
+                   &short_meshlet_vertices[meshlets[m].vertex_offset]);
+      }
+    }
+  }
+
+  std::vector<GLuint>().swap(indices);
+
+  for(std::vector<Lod>::iterator lod = lods.begin(); lod != lods.end(); ++lod) {
+    std::vector<GLuint>().swap(lod->indices);
+  }
+
+  std::vector<GLuint>().swap(meshlet_vertices);
+
+  return true;
+}
+
+void VBOMesh::split(size_t max_vertices, std::vector<VBOMesh *> & parts) const
+{
+  // Vertex of this mesh -> vertex of the current part, or -1.
+  std::vector<int> remap(get_vertex_count(), -1);
+  std::vector<GLuint> used;
+  VBOMesh * part = NULL;
+  const size_t first_part = parts.size();
+
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    const SubMesh * submesh = submeshes[s];
+
+    for(int t = 0; t < submesh->triangle_count; ++t) {
+      const GLuint * triangle = &indices[submesh->index_offset + t * TRIANGLE_VERTEX_COUNT];
+      size_t added = 0;
+
+      for(int k = 0; k < TRIANGLE_VERTEX_COUNT; ++k) {
+        added += remap[triangle[k]] < 0 && (k < 1 || triangle[k] != triangle[0]) && (k < 2 || triangle[k] != triangle[1]);
+      }
+
+      if(part == NULL || used.size() + added > max_vertices) {
+        for(std::vector<GLuint>::iterator v = used.begin(); v != used.end(); ++v) {
+          remap[*v] = -1;
+        }
+
+        used.clear();
+
+        part = new VBOMesh;
+        part->name = name;
+        part->has_normal = has_normal;
+        part->has_uv = has_uv;
+        part->all_by_control_points = all_by_control_points;
 
+        for(int i = 0; i < submeshes.GetCount(); ++i) {
+          part->submeshes.Add(new SubMesh);
+        }
+
+        for(std::vector<Channel>::const_iterator channel = channels.begin(); channel != channels.end(); ++channel) {
+          part->channels.push_back(Channel(channel->semantic, channel->set, channel->components));
+        }
+
+        parts.push_back(part);
+      }
+
+      // Submeshes are visited in order, so the part's current one is the
+      // last to receive triangles and its range grows at the end.
+      SubMesh * part_submesh = part->submeshes[s];
+
+      if(part_submesh->triangle_count == 0) {
+        part_submesh->index_offset = static_cast<int>(part->indices.size());
+      }
+
+      for(int k = 0; k < TRIANGLE_VERTEX_COUNT; ++k) {
+        const GLuint vertex = triangle[k];
+
+        if(remap[vertex] < 0) {
+          remap[vertex] = static_cast<int>(used.size());
+          used.push_back(vertex);
+
+          part->vertices.insert(part->vertices.end(), &vertices[vertex * VERTEX_STRIDE], &vertices[vertex * VERTEX_STRIDE] + VERTEX_STRIDE);
+
+          if(!control_point_indices.empty()) {
+            part->control_point_indices.push_back(control_point_indices[vertex]);
+          }
+
+          if(!normals.empty()) {
+            part->normals.insert(part->normals.end(), &normals[vertex * NORMAL_STRIDE], &normals[vertex * NORMAL_STRIDE] + NORMAL_STRIDE);
+          }
+
+          if(!uvs.empty()) {
+            part->uvs.insert(part->uvs.end(), &uvs[vertex * UV_STRIDE], &uvs[vertex * UV_STRIDE] + UV_STRIDE);
+          }
+
+          for(size_t c = 0; c < channels.size(); ++c) {
+            const float * values = &channels[c].data[vertex * channels[c].components];
+            part->channels[c].data.insert(part->channels[c].data.end(), values, values + channels[c].components);
+          }
+        }
+
+        part->indices.push_back(static_cast<GLuint>(remap[vertex]));
+      }
+
+      part_submesh->triangle_count += 1;
+    }
+  }
+
+  for(size_t p = first_part; p < parts.size(); ++p) {
+    parts[p]->recompute_bounds();
+    parts[p]->animation_bounds = animation_bounds;
+  }
+}
+
+bool VBOMesh::generate_tangents(const int thread_count)
+{
+  if(!has_normal || normals.empty() || uvs.empty() || indices.empty()) {
+    return false;
+  }
+
+  for(std::vector<Channel>::const_iterator channel = channels.begin(); channel != channels.end(); ++channel) {
+    if(channel->semantic == MeshStream::SEMANTIC_TANGENT) {
+      return false;
+    }
+  }
+
+  Channel tangents(MeshStream::SEMANTIC_TANGENT, 0, TANGENT_STRIDE);
+  std::vector<unsigned int> copies;
+
+  Fbx2Json::generate_tangents(tangents.data, copies, &indices[0], indices.size(), &vertices[0], VERTEX_STRIDE, &normals[0],
+                              &uvs[0], get_vertex_count(), thread_count);
+
+  append_vertex_copies(copies);
+  channels.push_back(tangents);
+
+  return true;
+}
+
+float VBOMesh::get_acmr() const
+{
+  return indices.empty() ? 0.f : compute_acmr(&indices[0], indices.size(), get_vertex_count());
+}
+
+void VBOMesh::optimize_vertex_cache()
+{
+  if(indices.empty()) {
+    return;
+  }
+
+  // Submeshes are drawn separately, so triangles only move within their own
+  // range.
+  std::vector<GLuint> optimized(indices.size());
+
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    const SubMesh * submesh = submeshes[s];
+
+    if(submesh->triangle_count > 0) {
+      Fbx2Json::optimize_vertex_cache(&optimized[submesh->index_offset], &indices[submesh->index_offset],
+                                      submesh->triangle_count * TRIANGLE_VERTEX_COUNT, get_vertex_count());
+    }
+  }
+
+  indices.swap(optimized);
+}
+
+void VBOMesh::optimize_overdraw(const float threshold)
+{
+  if(indices.empty()) {
+    return;
+  }
+
+  std::vector<GLuint> optimized(indices.size());
+
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    const SubMesh * submesh = submeshes[s];
+
+    if(submesh->triangle_count > 0) {
+      Fbx2Json::optimize_overdraw(&optimized[submesh->index_offset], &indices[submesh->index_offset],
+                                  submesh->triangle_count * TRIANGLE_VERTEX_COUNT, &vertices[0], get_vertex_count(),
+                                  VERTEX_STRIDE, threshold);
+    }
+  }
+
+  indices.swap(optimized);
+}
+
+void VBOMesh::optimize_vertex_fetch()
+{
+  if(indices.empty()) {
+    return;
+  }
+
+  std::vector<unsigned int> remap(get_vertex_count());
+  const size_t used = optimize_vertex_fetch_remap(&remap[0], &indices[0], indices.size(), get_vertex_count());
+
+  remap_vertices(remap, used);
+}
+
+bool VBOMesh::add_lod(const float ratio, const float target_error, const bool lock_border, const bool optimize_cache)
+{
+  if(indices.empty()) {
+    return false;
+  }
+
+  const size_t vertex_count = get_vertex_count();
+
+  // Positions used by more than one submesh lie on a material boundary.
+  std::vector<unsigned int> remap(vertex_count);
+  std::vector<int> owner(vertex_count, -1);
+  std::vector<unsigned char> locked(vertex_count, 0);
+
+  build_position_remap(&remap[0], &vertices[0], vertex_count, VERTEX_STRIDE);
+
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    const SubMesh * submesh = submeshes[s];
+
+    for(int i = 0; i < submesh->triangle_count * TRIANGLE_VERTEX_COUNT; ++i) {
+      const unsigned int position = remap[indices[submesh->index_offset + i]];
+
+      if(owner[position] < 0) {
+        owner[position] = s;
+      } else if(owner[position] != s) {
+        locked[position] = 1;
+      }
+    }
+  }
+
+  const size_t normal_count = normals.empty() ? 0 : 3;
+  const size_t uv_count = uvs.empty() ? 0 : 2;
+  const size_t attribute_count = normal_count + uv_count;
+  std::vector<float> attributes(vertex_count * attribute_count);
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    float * attribute = &attributes[v * attribute_count];
+
+    for(size_t k = 0; k < normal_count; ++k) {
+      attribute[k] = normals[v * NORMAL_STRIDE + k] * LOD_NORMAL_WEIGHT;
+    }
+
+    for(size_t k = 0; k < uv_count; ++k) {
+      attribute[normal_count + k] = uvs[v * UV_STRIDE + k] * LOD_UV_WEIGHT;
+    }
+  }
+
+  const size_t previous_count = lods.empty() ? indices.size() : lods.back().indices.size();
+  const float previous_error = lods.empty() ? 0.f : lods.back().error;
+  const float scale = simplify_scale(&vertices[0], vertex_count, VERTEX_STRIDE);
+
+  lods.push_back(Lod());
+
+  Lod & lod = lods.back();
+  lod.indices.resize(indices.size());
+  lod.submeshes.resize(submeshes.GetCount());
+
+  size_t offset = 0;
+
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    const SubMesh * submesh = submeshes[s];
+    const size_t target = static_cast<size_t>(submesh->triangle_count * ratio) * TRIANGLE_VERTEX_COUNT;
+    float error = 0.f;
+    const size_t count = simplify(&lod.indices[offset], &indices[submesh->index_offset], submesh->triangle_count * TRIANGLE_VERTEX_COUNT,
+                                  &vertices[0], vertex_count, VERTEX_STRIDE, attributes.empty() ? NULL : &attributes[0],
+                                  attribute_count, &locked[0], lock_border, target, target_error, &error);
+
+    if(optimize_cache && count > 0) {
+      const std::vector<GLuint> simplified(lod.indices.begin() + offset, lod.indices.begin() + offset + count);
+      Fbx2Json::optimize_vertex_cache(&lod.indices[offset], &simplified[0], count, vertex_count);
+    }
+
+    lod.submeshes[s].index_offset = static_cast<int>(offset);
+    lod.submeshes[s].triangle_count = static_cast<int>(count / TRIANGLE_VERTEX_COUNT);
+    lod.error = std::max(lod.error, error * scale);
+    offset += count;
+  }
+
+  if(offset >= previous_count || offset == 0) {
+    lods.pop_back();
+    return false;
+  }
+
+  lod.indices.resize(offset);
+
+  // Errors never decrease down the chain, so a level can be picked by them.
+  lod.error = std::max(lod.error, previous_error);
+
+  return true;
+}
+
+template<typename T>
+static void remap_array(std::vector<T> & data, const int stride, const std::vector<unsigned int> & remap, const size_t vertex_count)
+{
+  if(data.empty()) {
+    return;
+  }
+
+  std::vector<T> remapped(vertex_count * stride);
+
+  for(size_t v = 0; v < remap.size(); ++v) {
+    if(remap[v] != VERTEX_UNUSED) {
+      memcpy(&remapped[remap[v] * stride], &data[v * stride], stride * sizeof(T));
+    }
+  }
+
+  data.swap(remapped);
+}
+
+void VBOMesh::remap_vertices(const std::vector<unsigned int> & remap, const size_t vertex_count)
+{
+  // Vertices no longer line up with control points once moved, so keep
+  // track of where each came from for update_vertex_position.
   if(all_by_control_points) {
-    vertex_count = mesh->GetControlPointsCount();
-    vertices = std::vector<float>(vertex_count * VERTEX_STRIDE);
+    control_point_indices.resize(remap.size());
+
+    for(size_t v = 0; v < remap.size(); ++v) {
+      control_point_indices[v] = static_cast<int>(v);
+    }
+
+    all_by_control_points = false;
+  }
+
+  remap_array(vertices, VERTEX_STRIDE, remap, vertex_count);
+  remap_array(normals, NORMAL_STRIDE, remap, vertex_count);
+  remap_array(uvs, UV_STRIDE, remap, vertex_count);
+
+  for(std::vector<Channel>::iterator channel = channels.begin(); channel != channels.end(); ++channel) {
+    remap_array(channel->data, channel->components, remap, vertex_count);
+  }
+  remap_array(control_point_indices, 1, remap, vertex_count);
+
+  // Dropping vertices can shrink the bounds.
+  if(vertex_count < remap.size()) {
+    recompute_bounds();
+  }
 
-    for(int i = 0; i < vertex_count; ++i) {
-      vertices[i * VERTEX_STRIDE] = static_cast<float>(deformed_vertices[i][0]);
-      vertices[i * VERTEX_STRIDE + 1] = static_cast<float>(deformed_vertices[i][1]);
-      vertices[i * VERTEX_STRIDE + 2] = static_cast<float>(deformed_vertices[i][2]);
-      vertices[i * VERTEX_STRIDE + 3] = 1;
+  for(std::vector<GLuint>::iterator index = indices.begin(); index != indices.end(); ++index) {
+    *index = remap[*index];
+  }
+
+  for(std::vector<Lod>::iterator lod = lods.begin(); lod != lods.end(); ++lod) {
+    for(std::vector<GLuint>::iterator index = lod->indices.begin(); index != lod->indices.end(); ++index) {
+      *index = remap[*index];
     }
+  }
+}
+
+template<typename T>
+static void append_copies(std::vector<T> & data, const int stride, const std::vector<unsigned int> & copies)
+{
+  if(data.empty()) {
+    return;
+  }
+
+  const size_t vertex_count = data.size() / stride;
+  data.resize((vertex_count + copies.size()) * stride);
+
+  for(size_t c = 0; c < copies.size(); ++c) {
+    memcpy(&data[(vertex_count + c) * stride], &data[copies[c] * stride], stride * sizeof(T));
+  }
+}
+
+void VBOMesh::append_vertex_copies(const std::vector<unsigned int> & copies)
+{
+  if(copies.empty()) {
+    return;
+  }
+
+  // Copies share a control point with the vertex they copy.
+  if(all_by_control_points) {
+    control_point_indices.resize(get_vertex_count());
+
+    for(size_t v = 0; v < control_point_indices.size(); ++v) {
+      control_point_indices[v] = static_cast<int>(v);
+    }
+
+    all_by_control_points = false;
+  }
+
+  append_copies(vertices, VERTEX_STRIDE, copies);
+  append_copies(normals, NORMAL_STRIDE, copies);
+  append_copies(uvs, UV_STRIDE, copies);
+
+  for(std::vector<Channel>::iterator channel = channels.begin(); channel != channels.end(); ++channel) {
+    append_copies(channel->data, channel->components, copies);
+  }
+  append_copies(control_point_indices, 1, copies);
+}
+
+void VBOMesh::recompute_bounds()
+{
+  bounds = Bounds();
+
+  if(!vertices.empty()) {
+    add_points(bounds, &vertices[0], VERTEX_STRIDE, NULL, get_vertex_count());
+    fit_sphere(bounds, &vertices[0], VERTEX_STRIDE, NULL, get_vertex_count());
+  }
+}
+
+// Each submesh's box and sphere come from the vertices its indices use,
+// gathered straight from the index range.
+void VBOMesh::compute_submesh_bounds()
+{
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    SubMesh * submesh = submeshes[s];
+    submesh->bounds = Bounds();
+
+    if(submesh->triangle_count > 0) {
+      const GLuint * range = &indices[submesh->index_offset];
+      const size_t count = submesh->triangle_count * TRIANGLE_VERTEX_COUNT;
+
+      add_points(submesh->bounds, &vertices[0], VERTEX_STRIDE, range, count);
+      fit_sphere(submesh->bounds, &vertices[0], VERTEX_STRIDE, range, count);
+    }
+  }
+}
+
+bool VBOMesh::build_meshlets()
+{
+  meshlets.clear();
+  meshlet_bounds.clear();
+  meshlet_vertices.clear();
+  meshlet_triangles.clear();
+
+  if(indices.empty()) {
+    return false;
+  }
+
+  // Submeshes are drawn separately, so meshlets never mix materials.
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    SubMesh * submesh = submeshes[s];
+
+    submesh->meshlet_offset = static_cast<int>(meshlets.size());
+    submesh->meshlet_count = 0;
+
+    if(submesh->triangle_count > 0) {
+      submesh->meshlet_count = static_cast<int>(
+        Fbx2Json::build_meshlets(meshlets, meshlet_vertices, meshlet_triangles, &indices[submesh->index_offset],
+                                 submesh->triangle_count * TRIANGLE_VERTEX_COUNT, &vertices[0], get_vertex_count(),
+                                 VERTEX_STRIDE, MAX_MESHLET_VERTICES, MAX_MESHLET_TRIANGLES));
+    }
+  }
+
+  for(std::vector<Meshlet>::const_iterator meshlet = meshlets.begin(); meshlet != meshlets.end(); ++meshlet) {
+    meshlet_bounds.push_back(compute_meshlet_bounds(*meshlet, &meshlet_vertices[0], &meshlet_triangles[0], &vertices[0],
+                                                    VERTEX_STRIDE));
+  }
+
+  return !meshlets.empty();
+}
+
+CleanupResult VBOMesh::clean_up(const bool static_positions)
+{
+  CleanupResult result;
+  const size_t vertex_count = get_vertex_count();
+
+  if(indices.empty()) {
+    return result;
+  }
+
+  std::vector<unsigned int> points(vertex_count);
+
+  if(static_positions) {
+    build_position_remap(&points[0], &vertices[0], vertex_count, VERTEX_STRIDE);
   } else {
-    const int polygon_count = mesh->GetPolygonCount();
-    vertex_count = polygon_count * TRIANGLE_VERTEX_COUNT;
-    vertices = std::vector<float>(vertex_count * VERTEX_STRIDE);
+    for(size_t v = 0; v < vertex_count; ++v) {
+      points[v] = all_by_control_points ? static_cast<unsigned int>(v) : control_point_indices[v];
+    }
+  }
+
+  // Submeshes lie in order in `indices`, so each one moves down over the
+  // triangles removed before it.
+  size_t index_count = 0;
+
+  for(int s = 0; s < submeshes.GetCount(); ++s) {
+    SubMesh * submesh = submeshes[s];
+    GLuint * range = &indices[0] + submesh->index_offset;
+    const size_t kept = remove_degenerate_triangles(range, submesh->triangle_count * TRIANGLE_VERTEX_COUNT, &points[0],
+                                                    static_positions ? &vertices[0] : NULL, VERTEX_STRIDE, result);
+
+    std::copy(range, range + kept, indices.begin() + index_count);
+    submesh->index_offset = static_cast<int>(index_count);
+    submesh->triangle_count = static_cast<int>(kept / TRIANGLE_VERTEX_COUNT);
+    index_count += kept;
+  }
+
+  indices.resize(index_count);
+
+  // Unused vertices go, the others keep their order.
+  std::vector<unsigned int> remap(vertex_count, VERTEX_UNUSED);
+  unsigned int used = 0;
+
+  for(std::vector<GLuint>::const_iterator index = indices.begin(); index != indices.end(); ++index) {
+    remap[*index] = 0;
+  }
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    if(remap[v] != VERTEX_UNUSED) {
+      remap[v] = used++;
+    }
+  }
+
+  result.unused_vertices = vertex_count - used;
+
+  if(used < vertex_count) {
+    remap_vertices(remap, used);
+  }
 
-    int vertex_count = 0;
+  return result;
+}
 
-    for(int i = 0; i < polygon_count; ++i) {
-      for(int j = 0; j < TRIANGLE_VERTEX_COUNT; ++j) {
-        const int control_point_index = mesh->GetPolygonVertex(i, j);
-        vertices[vertex_count * VERTEX_STRIDE] = static_cast<float>(deformed_vertices[control_point_index][0]);
-        vertices[vertex_count * VERTEX_STRIDE + 1] = static_cast<float>(deformed_vertices[control_point_index][1]);
-        vertices[vertex_count * VERTEX_STRIDE + 2] = static_cast<float>(deformed_vertices[control_point_index][2]);
-        vertices[vertex_count * VERTEX_STRIDE + 3] = 1;
+bool VBOMesh::build_bvh()
+{
+  bvh_nodes.clear();
+  bvh_triangles.clear();
 
-        ++vertex_count;
+  if(short_indices.empty()) {
+    if(!indices.empty()) {
+      Fbx2Json::build_bvh(bvh_nodes, bvh_triangles, &indices[0], indices.size(), &vertices[0], VERTEX_STRIDE);
+    }
+  } else {
+    std::vector<GLuint> wide_indices(short_indices.begin(), short_indices.end());
+
+    for(int s = 0; s < submeshes.GetCount(); ++s) {
+      const SubMesh * submesh = submeshes[s];
+
+      for(int i = 0; i < submesh->triangle_count * TRIANGLE_VERTEX_COUNT; ++i) {
+        wide_indices[submesh->index_offset + i] += submesh->base_vertex;
       }
     }
+
+    Fbx2Json::build_bvh(bvh_nodes, bvh_triangles, &wide_indices[0], wide_indices.size(), &vertices[0], VERTEX_STRIDE);
   }
+
+  return !bvh_nodes.empty();
+}
+
+void VBOMesh::update_vertex_position(const FbxVector4 * deformed_vertices)
+{
+  if(!vertices.empty()) {
+    bounds = update_vertex_position(deformed_vertices, &vertices[0]);
+    merge_bounds(animation_bounds, bounds);
+  }
+}
+
+Bounds VBOMesh::update_vertex_position(const FbxVector4 * deformed_vertices, float * destination) const
+{
+  const double * source = reinterpret_cast<const double *>(deformed_vertices);
+  Bounds frame_bounds;
+
+  if(all_by_control_points) {
+    convert_points(destination, source, 4, NULL, get_vertex_count(), frame_bounds.min, frame_bounds.max);
+  } else if(!control_point_indices.empty()) {
+    convert_points(destination, source, 4, &control_point_indices[0], control_point_indices.size(), frame_bounds.min,
+                   frame_bounds.max);
+  }
+
+  fit_sphere(frame_bounds, destination, VERTEX_STRIDE, NULL, get_vertex_count());
+
+  return frame_bounds;
 }
 
 } // namespace Fbx2Json
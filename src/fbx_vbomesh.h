@@ -23,27 +23,185 @@
 #ifndef FBX2JSON_FBXVBOMESH_H_
 #define FBX2JSON_FBXVBOMESH_H_
 
+#include <string>
 #include <vector>
 #include <fbxsdk.h>
 #include <glew.h>
+#include "fbx_bounds.h"
+#include "fbx_bvh.h"
+#include "fbx_cleanup.h"
+#include "fbx_mesh_stream.h"
+#include "fbx_meshlet.h"
 
 namespace Fbx2Json
 {
 class VBOMesh
 {
   public:
+    // Range of `indices` drawn with one material, the material slot being
+    // the index of the submesh, the range of `meshlets` cut from it and the
+    // bounds of the vertices it uses. `base_vertex` is added to its 16-bit
+    // indices and meshlet vertices when the mesh as a whole is too large
+    // for them.
+    struct SubMesh {
+      SubMesh() : index_offset(0), triangle_count(0), base_vertex(0), meshlet_offset(0), meshlet_count(0) {}
+      int index_offset;
+      int triangle_count;
+      int base_vertex;
+      int meshlet_offset;
+      int meshlet_count;
+      Bounds bounds;
+    };
+
+    // A per-vertex attribute beyond positions, normals and the first uv set:
+    // further uv sets, vertex colours (RGBA) and tangents (XYZ and the
+    // handedness in W), `components` floats per vertex.
+    struct Channel {
+      Channel(MeshStream::Semantic semantic, int set, int components) :
+        semantic(semantic), set(set), components(components) {}
+      MeshStream::Semantic semantic;
+      int set;
+      int components;
+      std::vector<float> data;
+    };
+
+    // A coarser level of detail drawn from the same vertices: its own
+    // indices and a range of them per material slot. `error` is how far, in
+    // mesh units, its surface may stray from the full-detail one.
+    struct Lod {
+      Lod() : error(0.f) {}
+      MeshStream get_index_stream() const;
+      float error;
+      std::vector<SubMesh> submeshes;
+      std::vector<GLuint> indices;
+      std::vector<GLushort> short_indices;
+    };
+
+    // Uv sets and colour layers read, those beyond are dropped.
+    static const int MAX_UV_SETS = 8;
+    static const int MAX_COLOR_SETS = 4;
+
+    // Largest vertex count that 16-bit indices can address while keeping
+    // 0xffff free for primitive restart.
+    static const size_t MAX_SHORT_INDEX_VERTICES = 65535;
+
     VBOMesh();
     ~VBOMesh();
     bool initialize(const FbxMesh * mesh);
-    void update_vertex_position(FbxMesh * mesh, const FbxVector4 * vertices);
+
+    // Replaces the positions with deformed control points, one per control
+    // point of the mesh given to initialize, and adds the frame's bounds to
+    // `animation_bounds`. The second form writes the get_vertex_count() XYZW
+    // positions to `destination` instead, so frames can be baked into
+    // storage the caller owns, and returns their bounds.
+    void update_vertex_position(const FbxVector4 * deformed_vertices);
+    Bounds update_vertex_position(const FbxVector4 * deformed_vertices, float * destination) const;
+
+    // Drops the triangles described in fbx_cleanup.h and then the vertices
+    // no triangle uses. Points are compared by position when the positions
+    // are static, and by control point when deformation will move them,
+    // which also skips the area test. Call right after initialize.
+    CleanupResult clean_up(bool static_positions);
+
     int get_submesh_count() const {
       return submeshes.GetCount();
     }
+    const SubMesh * get_submesh(int index) const {
+      return submeshes[index];
+    }
+
+    size_t get_vertex_count() const {
+      return vertices.size() / 4;
+    }
+
+    // Moves the indices, those of the levels of detail and the meshlet vertex
+    // table to their 16-bit arrays when the mesh is small enough or, with
+    // `base_vertex`, when each submesh uses a range of at most
+    // MAX_SHORT_INDEX_VERTICES vertices; those are then stored relative to
+    // the first vertex of the range, the submesh's base_vertex. Only call
+    // this once the indices are final.
+    bool pack_indices(bool base_vertex);
+
+    // Cuts the mesh into parts of at most `max_vertices` vertices each, with
+    // triangles kept in order and submeshes keeping their material slot.
+    // Parts get bounds of their own and share the mesh's animation bounds.
+    void split(size_t max_vertices, std::vector<VBOMesh *> & parts) const;
+
+    // Fills in the bounds of each submesh. Call once the positions are final,
+    // after split and before pack_indices.
+    void compute_submesh_bounds();
+
+    // Adds tangents computed as described in fbx_tangents.h, unless the mesh
+    // has some already or lacks the normals and uvs they derive from.
+    // Vertices where mirrored uvs meet are split, so call it before the
+    // optimisation passes.
+    bool generate_tangents(int thread_count);
+
+    // Average cache miss ratio of the 32-bit indices, see fbx_vertex_cache.h.
+    float get_acmr() const;
+
+    // Optimisation passes, run in this order before pack_indices and split.
+    // The first two reorder triangles within each submesh, for the
+    // post-transform vertex cache and then for less overdraw (see
+    // fbx_overdraw.h). The last stores vertices in the order the indices
+    // first use them and drops unused ones.
+    void optimize_vertex_cache();
+    void optimize_overdraw(float threshold);
+    void optimize_vertex_fetch();
+
+    // Appends a level of detail simplified from the full mesh (see
+    // fbx_simplify.h) down to `ratio` of the triangles of each submesh, or
+    // as far as it goes without exceeding `target_error`, a fraction of the
+    // mesh's size. Positions shared by several materials never move so that
+    // submeshes still meet, nor do open borders with `lock_border`. Returns
+    // false, adding nothing, when the level would have no fewer triangles
+    // than the previous one, or none at all. Call after the optimisation
+    // passes and split.
+    bool add_lod(float ratio, float target_error, bool lock_border, bool optimize_cache);
 
+    // Cuts each submesh into meshlets as described in fbx_meshlet.h and
+    // computes their bounds from the current positions. Call after split and
+    // before pack_indices.
+    bool build_meshlets();
+
+    // Builds the triangle hierarchy described in fbx_bvh.h from the current
+    // positions. Works on 16 or 32-bit indices, so it can run after
+    // pack_indices; meshes are independent, so it can run on several at once.
+    bool build_bvh();
+
+    // Views of the arrays below. Vertex streams come in storage order
+    // (positions, normals, uvs, then channels) and include empty ones.
+    // Meshlet streams are the bounds, ranges, triangle and vertex tables,
+    // hierarchy streams the nodes and triangle table.
+    MeshStream get_index_stream() const;
+    void get_vertex_streams(std::vector<MeshStream> & streams) const;
+    void get_meshlet_streams(std::vector<MeshStream> & streams) const;
+    void get_bvh_streams(std::vector<MeshStream> & streams) const;
+
+    std::string name;
+    // Bounds of `vertices`, kept up to date as positions are written, and
+    // their union over every frame passed to update_vertex_position (empty
+    // when there was none).
+    Bounds bounds;
+    Bounds animation_bounds;
     std::vector<float> vertices;
     std::vector<float> normals;
     std::vector<float> uvs;
     std::vector<GLuint> indices;
+    std::vector<GLushort> short_indices;
+    std::vector<Channel> channels;
+    std::vector<Lod> lods;
+    // Meshlets of all submeshes in submesh order, with their bounds at the
+    // same positions and the tables they index into.
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> meshlet_bounds;
+    std::vector<GLuint> meshlet_vertices;
+    std::vector<GLushort> short_meshlet_vertices;
+    std::vector<GLubyte> meshlet_triangles;
+    // Triangle hierarchy in depth-first order and the triangle numbers its
+    // leaves refer to.
+    std::vector<BvhNode> bvh_nodes;
+    std::vector<GLuint> bvh_triangles;
 
   private:
     enum {
@@ -54,14 +212,26 @@ class VBOMesh
       VBO_COUNT,
     };
 
-    struct SubMesh {
-      SubMesh() : index_offset(0), triangle_count(0) {}
-      int index_offset;
-      int triangle_count;
-    };
+    // Control point, position, normal, uv sets, colours and tangent.
+    static const int MAX_VERTEX_KEY_WORDS = 1 + 3 + 3 + MAX_UV_SETS * 2 + MAX_COLOR_SETS * 4 + 4;
+
+    bool read_channel(const FbxMesh * mesh, const FbxLayerElement * element, Channel & channel) const;
+    int vertex_key(int index, unsigned int * words) const;
+    GLuint weld_vertex(int index, std::vector<GLuint> & table) const;
+    void remap_vertices(const std::vector<unsigned int> & remap, size_t vertex_count);
+    // First vertex of the range each submesh uses, when every range fits
+    // 16-bit indices.
+    bool find_base_vertices(std::vector<GLuint> & bases) const;
+    // Appends a copy of each vertex listed, every attribute included.
+    void append_vertex_copies(const std::vector<unsigned int> & copies);
+    // Recomputes `bounds` from the positions.
+    void recompute_bounds();
 
     GLuint vbo_names[VBO_COUNT];
     FbxArray<SubMesh*> submeshes;
+    // Control point each vertex was built from, when not all_by_control_points.
+    // Filled in by initialize so deformed frames are a plain gather.
+    std::vector<int> control_point_indices;
     bool has_normal;
     bool has_uv;
     bool all_by_control_points;
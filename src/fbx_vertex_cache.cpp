@@ -0,0 +1,264 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <vector>
+#include "fbx_vertex_cache.h"
+
+namespace Fbx2Json
+{
+
+// Scoring constants from Forsyth's article.
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+// Valences at or above this share the last table entry, their boost being
+// negligible by then.
+const unsigned int MAX_SCORED_VALENCE = 64;
+
+struct VertexScores {
+  VertexScores();
+  float score(int cache_position, unsigned int live_triangles) const;
+
+  float cache[VERTEX_CACHE_SIZE];
+  float valence[MAX_SCORED_VALENCE];
+};
+
+VertexScores::VertexScores()
+{
+  for(size_t i = 0; i < VERTEX_CACHE_SIZE; ++i) {
+    if(i < 3) {
+      // The vertices of the last triangle get a fixed score so that the
+      // next triangle does not simply reuse the same edge every time.
+      cache[i] = LAST_TRIANGLE_SCORE;
+    } else {
+      const float scale = 1.f / (VERTEX_CACHE_SIZE - 3);
+      cache[i] = std::pow(1.f - (i - 3) * scale, CACHE_DECAY_POWER);
+    }
+  }
+
+  for(unsigned int i = 0; i < MAX_SCORED_VALENCE; ++i) {
+    valence[i] = i == 0 ? 0.f : VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+  }
+}
+
+// Vertices with no triangles left score nothing; the rest are favoured when
+// they sit in the cache and when few triangles still use them, so that
+// lone triangles do not get left behind.
+float VertexScores::score(int cache_position, unsigned int live_triangles) const
+{
+  if(live_triangles == 0) {
+    return 0.f;
+  }
+
+  const float cache_score = cache_position < 0 ? 0.f : cache[cache_position];
+  const unsigned int valence_index = live_triangles < MAX_SCORED_VALENCE ? live_triangles : MAX_SCORED_VALENCE - 1;
+
+  return cache_score + valence[valence_index];
+}
+
+void optimize_vertex_cache(unsigned int * destination, const unsigned int * indices, size_t index_count, size_t vertex_count)
+{
+  const size_t triangle_count = index_count / 3;
+
+  if(triangle_count == 0) {
+    return;
+  }
+
+  // Triangles using each vertex: adjacency[offsets[v] .. offsets[v] + live[v]).
+  std::vector<unsigned int> live(vertex_count, 0);
+  std::vector<unsigned int> offsets(vertex_count, 0);
+  std::vector<unsigned int> adjacency(triangle_count * 3);
+
+  for(size_t i = 0; i < triangle_count * 3; ++i) {
+    ++live[indices[i]];
+  }
+
+  for(size_t v = 1; v < vertex_count; ++v) {
+    offsets[v] = offsets[v - 1] + live[v - 1];
+  }
+
+  std::vector<unsigned int> fill(offsets);
+
+  for(size_t i = 0; i < triangle_count * 3; ++i) {
+    adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+  }
+
+  const VertexScores scores;
+  std::vector<float> vertex_scores(vertex_count);
+  std::vector<float> triangle_scores(triangle_count);
+  std::vector<bool> emitted(triangle_count, false);
+
+  for(size_t v = 0; v < vertex_count; ++v) {
+    vertex_scores[v] = scores.score(-1, live[v]);
+  }
+
+  for(size_t t = 0; t < triangle_count; ++t) {
+    triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+  }
+
+  unsigned int cache[VERTEX_CACHE_SIZE + 3];
+  size_t cache_count = 0;
+  size_t input_cursor = 0;
+  size_t output_count = 0;
+  size_t current = 0;
+
+  for(;;) {
+    const unsigned int * triangle = &indices[current * 3];
+
+    destination[output_count * 3] = triangle[0];
+    destination[output_count * 3 + 1] = triangle[1];
+    destination[output_count * 3 + 2] = triangle[2];
+    emitted[current] = true;
+
+    if(++output_count == triangle_count) {
+      break;
+    }
+
+    // The triangle's vertices move to the front of the cache, pushing the
+    // others back; anything past VERTEX_CACHE_SIZE falls out.
+    unsigned int next_cache[VERTEX_CACHE_SIZE + 3];
+    size_t next_count = 0;
+
+    for(int k = 0; k < 3; ++k) {
+      next_cache[next_count++] = triangle[k];
+    }
+
+    for(size_t i = 0; i < cache_count; ++i) {
+      const unsigned int v = cache[i];
+
+      if(v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+        next_cache[next_count++] = v;
+      }
+    }
+
+    for(int k = 0; k < 3; ++k) {
+      const unsigned int v = triangle[k];
+      unsigned int * list = &adjacency[offsets[v]];
+
+      for(unsigned int i = 0; i < live[v]; ++i) {
+        if(list[i] == current) {
+          list[i] = list[live[v] - 1];
+          --live[v];
+          break;
+        }
+      }
+    }
+
+    // Rescore every vertex whose cache position or valence changed and
+    // pass the difference on to its remaining triangles.
+    for(size_t i = 0; i < next_count; ++i) {
+      const unsigned int v = next_cache[i];
+      const int position = i < VERTEX_CACHE_SIZE ? static_cast<int>(i) : -1;
+      const float score = scores.score(position, live[v]);
+      const float delta = score - vertex_scores[v];
+      const unsigned int * list = &adjacency[offsets[v]];
+
+      vertex_scores[v] = score;
+
+      for(unsigned int j = 0; j < live[v]; ++j) {
+        triangle_scores[list[j]] += delta;
+      }
+    }
+
+    cache_count = next_count < VERTEX_CACHE_SIZE ? next_count : VERTEX_CACHE_SIZE;
+
+    for(size_t i = 0; i < cache_count; ++i) {
+      cache[i] = next_cache[i];
+    }
+
+    // The next triangle is the best one touching the cache. Only when none
+    // is left there do we fall back to the next unemitted input triangle.
+    float best_score = -1.f;
+    size_t best = triangle_count;
+
+    for(size_t i = 0; i < cache_count; ++i) {
+      const unsigned int v = cache[i];
+      const unsigned int * list = &adjacency[offsets[v]];
+
+      for(unsigned int j = 0; j < live[v]; ++j) {
+        if(triangle_scores[list[j]] > best_score) {
+          best_score = triangle_scores[list[j]];
+          best = list[j];
+        }
+      }
+    }
+
+    if(best == triangle_count) {
+      while(emitted[input_cursor]) {
+        ++input_cursor;
+      }
+
+      best = input_cursor;
+    }
+
+    current = best;
+  }
+}
+
+float compute_acmr(const unsigned int * indices, size_t index_count, size_t vertex_count)
+{
+  const size_t triangle_count = index_count / 3;
+
+  if(triangle_count == 0) {
+    return 0.f;
+  }
+
+  // A vertex is in the FIFO while fewer than VERTEX_CACHE_SIZE misses have
+  // happened since it was last loaded.
+  std::vector<size_t> loaded_at(vertex_count, 0);
+  size_t misses = 0;
+
+  for(size_t i = 0; i < triangle_count * 3; ++i) {
+    const unsigned int v = indices[i];
+
+    if(loaded_at[v] == 0 || misses - loaded_at[v] >= VERTEX_CACHE_SIZE) {
+      ++misses;
+      loaded_at[v] = misses;
+    }
+  }
+
+  return static_cast<float>(misses) / triangle_count;
+}
+
+size_t optimize_vertex_fetch_remap(unsigned int * remap, const unsigned int * indices, size_t index_count, size_t vertex_count)
+{
+  for(size_t v = 0; v < vertex_count; ++v) {
+    remap[v] = VERTEX_UNUSED;
+  }
+
+  unsigned int next = 0;
+
+  for(size_t i = 0; i < index_count; ++i) {
+    const unsigned int v = indices[i];
+
+    if(remap[v] == VERTEX_UNUSED) {
+      remap[v] = next++;
+    }
+  }
+
+  return next;
+}
+
+} // namespace Fbx2Json
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2013 Cameron Yule.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FBX2JSON_FBXVERTEXCACHE_H_
+#define FBX2JSON_FBXVERTEXCACHE_H_
+
+#include <cstddef>
+
+namespace Fbx2Json
+{
+
+// Size of the FIFO post-transform cache that optimisation and statistics
+// assume; 16 entries is a conservative fit for current GPUs.
+const size_t VERTEX_CACHE_SIZE = 16;
+
+// Reorders the triangles of a triangle list so that consecutive triangles
+// reuse recently transformed vertices, following Tom Forsyth's "Linear-Speed
+// Vertex Cache Optimisation". `destination` receives `index_count` indices and
+// must not alias `indices`.
+void optimize_vertex_cache(unsigned int * destination, const unsigned int * indices, size_t index_count, size_t vertex_count);
+
+// Average cache miss ratio: vertices transformed per triangle with a FIFO
+// cache of VERTEX_CACHE_SIZE entries. 0.5 is the best a regular grid can get,
+// 3 means no reuse at all.
+float compute_acmr(const unsigned int * indices, size_t index_count, size_t vertex_count);
+
+// Fills `remap` (vertex_count entries) with the position of each vertex once
+// vertices are sorted by first use in `indices`, so fetches walk the vertex
+// buffer forwards. Unused vertices map to VERTEX_UNUSED. Returns the number
+// of vertices used.
+const unsigned int VERTEX_UNUSED = ~0u;
+size_t optimize_vertex_fetch_remap(unsigned int * remap, const unsigned int * indices, size_t index_count, size_t vertex_count);
+
+} // namespace Fbx2Json
+
+#endif
@@ -20,14 +20,19 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <unistd.h>
 
 #define FBXSDK_NEW_API
 
 #include "fbx_importer.h"
 #include "fbx_parser.h"
 #include "fbx_exporter.h"
+#include "fbx_options.h"
 
 #define FBX2JSON_MAJOR "0"
 #define FBX2JSON_MINOR "1"
@@ -37,7 +42,60 @@ void usage(std::string prog)
 {
   std::cerr << prog << ": missing arguments" << std::endl << std::endl;
   std::cerr << "USAGE: " << prog;
-  std::cerr << "[FBX inputFile] [JSON outputFile]" << std::endl;
+  std::cerr << " [-f json|bin|glb] [-c] [-q 8|16] [-i attributes[:alignment]] [-j threads] [-z level] [-l] [-s] [-k] [-o threshold] [-d ratios] [-e errors] [-m] [-b] [-t] [-r] [-p digits] [-n digits] [-u digits]";
+  std::cerr << " [FBX inputFile] [JSON outputFile]" << std::endl;
+}
+
+// Reads "name,name,...:alignment" for -i, where "all" instead of the names
+// keeps the usual attribute order and the alignment is optional.
+bool parse_interleave(const std::string & argument, Fbx2Json::Options & options)
+{
+  const size_t colon = argument.find(':');
+  const std::string names = argument.substr(0, colon);
+
+  options.interleave = true;
+  options.interleave_order.clear();
+
+  if(colon != std::string::npos) {
+    options.vertex_alignment = atoi(argument.c_str() + colon + 1);
+
+    if(options.vertex_alignment < 4 || (options.vertex_alignment & (options.vertex_alignment - 1)) != 0) {
+      return false;
+    }
+  }
+
+  for(size_t start = 0; names != "all" && start <= names.size(); ) {
+    const size_t comma = std::min(names.find(',', start), names.size());
+
+    if(comma > start) {
+      options.interleave_order.push_back(names.substr(start, comma - start));
+    }
+
+    start = comma + 1;
+  }
+
+  return true;
+}
+
+// Reads the comma-separated list of numbers given to -d and -e, each of
+// which must lie above `min` and at most `max`.
+bool parse_levels(const std::string & argument, std::vector<float> & levels, float min, float max)
+{
+  levels.clear();
+
+  for(size_t start = 0; start <= argument.size(); ) {
+    const size_t comma = std::min(argument.find(',', start), argument.size());
+    const float level = static_cast<float>(atof(argument.substr(start, comma - start).c_str()));
+
+    if(!(level > min && level <= max)) {
+      return false;
+    }
+
+    levels.push_back(level);
+    start = comma + 1;
+  }
+
+  return true;
 }
 
 void version()
@@ -48,49 +106,189 @@ void version()
   std::cout << std::endl;
 }
 
-bool parse_arguments(int argc, char** argv)
+bool parse_arguments(int argc, char** argv, Fbx2Json::Options & options)
 {
   int c;
 
-  while((c = getopt(argc, argv, "v")) != -1) {
+  while((c = getopt(argc, argv, "vf:cq:i:j:z:lsko:d:e:mbtrp:n:u:")) != -1) {
     switch(c) {
       case 'v':
         version();
         return false;
         break;
+
+      case 'f':
+        if(std::string(optarg) == "json") {
+          options.format = Fbx2Json::Options::FORMAT_JSON;
+        } else if(std::string(optarg) == "bin") {
+          options.format = Fbx2Json::Options::FORMAT_BINARY;
+        } else if(std::string(optarg) == "glb") {
+          options.format = Fbx2Json::Options::FORMAT_GLB;
+        } else {
+          std::cerr << argv[0] << ": unknown format " << optarg << std::endl;
+          return false;
+        }
+
+        break;
+
+      case 'c':
+        options.compress = true;
+        break;
+
+      case 'q':
+        options.quantize_normal_bits = atoi(optarg);
+
+        if(options.quantize_normal_bits != 8 && options.quantize_normal_bits != 16) {
+          std::cerr << argv[0] << ": normals can be quantized to 8 or 16 bits" << std::endl;
+          return false;
+        }
+
+        break;
+
+      case 'i':
+        if(!parse_interleave(optarg, options)) {
+          std::cerr << argv[0] << ": vertex alignment must be a power of two of at least 4" << std::endl;
+          return false;
+        }
+
+        break;
+
+      case 'j':
+        options.thread_count = atoi(optarg);
+
+        if(options.thread_count < 1) {
+          std::cerr << argv[0] << ": at least one thread is needed" << std::endl;
+          return false;
+        }
+
+        break;
+
+      case 'z':
+        options.gzip_level = atoi(optarg);
+
+        if(options.gzip_level < 1 || options.gzip_level > 9) {
+          std::cerr << argv[0] << ": gzip levels range from 1 to 9" << std::endl;
+          return false;
+        }
+
+        break;
+
+      case 'l':
+        options.short_indices = false;
+        break;
+
+      case 's':
+        options.split_meshes = true;
+        break;
+
+      case 'k':
+        options.optimize_vertex_cache = false;
+        break;
+
+      case 'o':
+        options.overdraw_threshold = static_cast<float>(atof(optarg));
+
+        if(options.overdraw_threshold < 1) {
+          std::cerr << argv[0] << ": the overdraw threshold must be at least 1" << std::endl;
+          return false;
+        }
+
+        break;
+
+      case 'd':
+        if(!parse_levels(optarg, options.lod_ratios, 0.f, 1.f)) {
+          std::cerr << argv[0] << ": level of detail ratios must lie above 0 and at most 1" << std::endl;
+          return false;
+        }
+
+        break;
+
+      case 'e':
+        if(!parse_levels(optarg, options.lod_errors, 0.f, 1.f)) {
+          std::cerr << argv[0] << ": level of detail errors must lie above 0 and at most 1" << std::endl;
+          return false;
+        }
+
+        break;
+
+      case 'm':
+        options.build_meshlets = true;
+        break;
+
+      case 'b':
+        options.build_bvh = true;
+        break;
+
+      case 't':
+        options.generate_tangents = false;
+        break;
+
+      case 'r':
+        options.print_report = true;
+        break;
+
+      case 'p':
+        options.position_precision = atoi(optarg);
+        break;
+
+      case 'n':
+        options.normal_precision = atoi(optarg);
+        break;
+
+      case 'u':
+        options.uv_precision = atoi(optarg);
+        break;
+
+      default:
+        usage(argv[0]);
+        return false;
     }
   }
 
-  if(argc < 3) {
+  if(argc - optind < 2) {
     usage(argv[0]);
     return false;
   }
 
+  // The other formats have nowhere to put these, so rather than quietly
+  // writing full-size output, refuse them.
+  const bool binary_only = options.quantize_normal_bits != 0 || options.compress || options.interleave ||
+                           options.build_meshlets || options.build_bvh;
+
+  if(binary_only && options.format != Fbx2Json::Options::FORMAT_BINARY) {
+    std::cerr << argv[0] << ": -q, -c, -i, -m and -b only apply to the binary format (-f bin)" << std::endl;
+    return false;
+  }
+
   return true;
 }
 
 int main(int argc, char** argv)
 {
-  //  if(parse_arguments(argc, argv)) {
-  //    std::string input = argv[1];
-  //    std::string output = argv[2];
-  std::string input = "/Users/cameronyule/projects/personal/fbx2json/examples/Sahuagin_Weapon.fbx";
-  std::string output = "/Users/cameronyule/Desktop/out.js";
+  Fbx2Json::Options options;
+
+  if(parse_arguments(argc, argv, options)) {
+    std::string input = argv[optind];
+    std::string output = argv[optind + 1];
 
-  // Initialise the FBX SDK and import our FBX file
-  Fbx2Json::Importer importer = Fbx2Json::Importer();
-  importer.import(input);
+    // Initialise the FBX SDK and import our FBX file
+    Fbx2Json::Importer importer = Fbx2Json::Importer();
+    importer.import(input);
 
-  // Bake component parts of FBX for export
-  Fbx2Json::Parser parser = Fbx2Json::Parser();
-  parser.parse(importer.get_scene());
+    // Bake component parts of FBX for export
+    Fbx2Json::Parser parser = Fbx2Json::Parser(options);
+    parser.parse(importer.get_scene());
 
-  // Output JSON-formatted raw data
-  Fbx2Json::Exporter exporter = Fbx2Json::Exporter();
-  exporter.write(output, parser.get_meshes());
+    // Output JSON-formatted raw data
+    Fbx2Json::Exporter exporter = Fbx2Json::Exporter(options);
+    exporter.write(output, parser.get_meshes());
 
-  return EXIT_SUCCESS;
-  //  }
+    if(options.print_report) {
+      parser.get_report().print(std::cout);
+    }
+
+    return EXIT_SUCCESS;
+  }
 
-  //  return EXIT_FAILURE;
+  return EXIT_FAILURE;
 }